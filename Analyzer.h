@@ -0,0 +1,313 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "PluginParameters.h"
+#include "Filters.h"
+#include "Telemetry.h"
+#include "TripleBuffer.h"
+
+// ===== THREAD DI ANALISI =====
+// Un solo thread per tutte le istanze aperte (SharedResourcePointer): ogni analizzatore è un client
+class AnalyzerThread : public juce::TimeSliceThread
+{
+public:
+    AnalyzerThread() : juce::TimeSliceThread("FlangeFlicker Analyzer") { startThread(); }
+    ~AnalyzerThread() override { stopThread(1000); }
+};
+
+// ===== ANALIZZATORE DI SPETTRO =====
+// Spettro dell'uscita (da SpectrumTap) con sovrapposta la risposta in ampiezza del filtro.
+// La FFT gira sul thread di analisi, mai sul thread audio o su quello dei messaggi, e lo spettro
+// arriva all'editor con un TripleBuffer. update() va chiamato dal thread dei messaggi a ogni refresh
+// del display (VBlankAttachment): ridisegna solo se c'è uno spettro nuovo o il filtro è cambiato.
+// La risposta del filtro è calcolata dai coefficienti del biquad e tenuta in cache finché
+// cutoff, Q, tipo, attivazione, oversampling e sample rate restano uguali.
+class SpectrumAnalyzer : public juce::Component, private juce::TimeSliceClient
+{
+public:
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int hopSize = fftSize / 4;         // un nuovo spettro ogni hopSize campioni
+    static constexpr int numPoints = 256;               // punti in frequenza, spaziati in log
+    static constexpr float minFrequency = 20.0f, maxFrequency = 20000.0f;
+    static constexpr float minDb = -84.0f, maxDb = 12.0f;
+    static constexpr float releaseDbPerSecond = 40.0f;
+
+    using Spectrum = std::array<float, numPoints>;
+
+    SpectrumAnalyzer(SpectrumTap& tapToRead, juce::AudioProcessorValueTreeState& vts)
+        : tap(tapToRead),
+        fft(fftOrder),
+        window(static_cast<size_t>(fftSize), juce::dsp::WindowingFunction<float>::hann, false),
+        spectrum(makeFloor())
+    {
+        setInterceptsMouseClicks(false, false);
+
+        for (int i = 0; i < numPoints; ++i)
+            frequencies[(size_t)i] = minFrequency * std::pow(static_cast<double>(maxFrequency / minFrequency), i / (numPoints - 1.0));
+
+        filterActive = vts.getRawParameterValue(Parameters::nameFilterActive);
+        filterType = vts.getRawParameterValue(Parameters::nameFilterType);
+        filterCutoff = vts.getRawParameterValue(Parameters::nameFilterCutoff);
+        filterQuality = vts.getRawParameterValue(Parameters::nameQuality);
+        oversampling = vts.getRawParameterValue(Parameters::nameOversampling);
+
+        levels = makeFloor();
+        analyzerThread->addTimeSliceClient(this);
+    }
+
+    // Aspetta la fine di un'eventuale analisi in corso
+    ~SpectrumAnalyzer() override { analyzerThread->removeTimeSliceClient(this); }
+
+    // ====== Thread dei messaggi ======
+    void update()
+    {
+        const bool newSpectrum = spectrum.acquire();
+        const bool newResponse = updateFilterResponse();
+
+        if (newSpectrum || newResponse)
+            repaint();
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        auto area = getLocalBounds().toFloat().reduced(2.0f);
+
+        g.setColour(juce::Colours::black.withAlpha(0.35f));
+        g.fillRoundedRectangle(area, 4.0f);
+
+        // Griglia: 1-2-5 per decade in frequenza (etichette sulle decadi), 24 dB in ampiezza
+        struct GridLine { float frequency; const char* label; };
+        static constexpr GridLine frequencyLines[] = { { 50.0f, "" }, { 100.0f, "100" }, { 200.0f, "" }, { 500.0f, "" },
+            { 1000.0f, "1k" }, { 2000.0f, "" }, { 5000.0f, "" }, { 10000.0f, "10k" } };
+
+        g.setFont(10.0f);
+        for (const auto& line : frequencyLines)
+        {
+            const float x = frequencyToX(area, line.frequency);
+            g.setColour(juce::Colours::grey.withAlpha(0.25f));
+            g.drawVerticalLine(juce::roundToInt(x), area.getY(), area.getBottom());
+
+            g.setColour(juce::Colours::antiquewhite.withAlpha(0.6f));
+            g.drawText(line.label, juce::Rectangle<float>(x + 2.0f, area.getBottom() - 14.0f, 30.0f, 12.0f), juce::Justification::left, false);
+        }
+
+        for (int step = 0; step * 24.0f < -minDb; ++step)
+        {
+            const float db = -24.0f * static_cast<float>(step);
+            const float y = dbToY(area, db);
+            g.setColour(juce::Colours::grey.withAlpha(step == 0 ? 0.5f : 0.25f));
+            g.drawHorizontalLine(juce::roundToInt(y), area.getX(), area.getRight());
+
+            g.setColour(juce::Colours::antiquewhite.withAlpha(0.6f));
+            g.drawText(juce::String(juce::roundToInt(db)) + " dB", juce::Rectangle<float>(area.getX() + 4.0f, y - 12.0f, 50.0f, 12.0f),
+                juce::Justification::left, false);
+        }
+
+        // Spettro dell'uscita
+        const auto& values = spectrum.getReadBuffer();
+        juce::Path spectrumPath;
+        spectrumPath.startNewSubPath(area.getX(), area.getBottom());
+
+        for (int i = 0; i < numPoints; ++i)
+            spectrumPath.lineTo(frequencyToX(area, static_cast<float>(frequencies[(size_t)i])), dbToY(area, values[(size_t)i]));
+
+        spectrumPath.lineTo(area.getRight(), area.getBottom());
+        spectrumPath.closeSubPath();
+
+        g.setColour(juce::Colours::antiquewhite.withAlpha(0.25f));
+        g.fillPath(spectrumPath);
+        g.setColour(juce::Colours::antiquewhite.withAlpha(0.8f));
+        g.strokePath(spectrumPath, juce::PathStrokeType(1.0f));
+
+        // Risposta del filtro (0 dB sulla linea di 0 dBFS)
+        if (responseKey.active)
+        {
+            juce::Path responsePath;
+
+            for (int i = 0; i < numPoints; ++i)
+            {
+                const float x = frequencyToX(area, static_cast<float>(frequencies[(size_t)i]));
+                const float y = dbToY(area, juce::Decibels::gainToDecibels(static_cast<float>(response[(size_t)i]), minDb));
+
+                if (i == 0)
+                    responsePath.startNewSubPath(x, y);
+                else
+                    responsePath.lineTo(x, y);
+            }
+
+            g.setColour(juce::Colour::fromRGB(240, 190, 60));
+            g.strokePath(responsePath, juce::PathStrokeType(1.5f));
+        }
+    }
+
+private:
+    // ====== Thread di analisi ======
+    int useTimeSlice() override
+    {
+        const double sampleRate = tap.getSampleRate();
+        if (!juce::approximatelyEqual(sampleRate, analysisSampleRate))
+            prepareAnalysis(sampleRate);
+
+        for (;;)
+        {
+            const int numRead = tap.read(readBuffer.data(), static_cast<int>(readBuffer.size()));
+            if (numRead == 0)
+                break;
+
+            for (int i = 0; i < numRead; ++i)
+            {
+                history[(size_t)historyPosition] = readBuffer[(size_t)i];
+                historyPosition = (historyPosition + 1) % fftSize;
+            }
+
+            samplesSinceSpectrum += numRead;
+        }
+
+        // Al massimo uno spettro per chiamata: conta solo l'ultimo
+        if (samplesSinceSpectrum >= hopSize)
+        {
+            computeSpectrum(static_cast<float>(samplesSinceSpectrum / analysisSampleRate));
+            samplesSinceSpectrum = 0;
+        }
+
+        return 10;
+    }
+
+    void prepareAnalysis(double sampleRate)
+    {
+        analysisSampleRate = sampleRate;
+        history.fill(0.0f);
+        historyPosition = 0;
+        samplesSinceSpectrum = 0;
+        levels = makeFloor();
+
+        // Bin della FFT coperti da ciascun punto (fino a metà strada dai punti vicini)
+        const double pointRatio = std::sqrt(frequencies[1] / frequencies[0]);
+        const double binsPerHz = fftSize / sampleRate;
+
+        for (int i = 0; i < numPoints; ++i)
+        {
+            const double frequency = frequencies[(size_t)i];
+            const int centre = juce::roundToInt(frequency * binsPerHz);
+            firstBin[(size_t)i] = juce::jlimit(1, fftSize / 2, juce::jmin(centre, static_cast<int>(frequency / pointRatio * binsPerHz)));
+            lastBin[(size_t)i] = juce::jlimit(firstBin[(size_t)i], fftSize / 2, juce::jmax(centre, static_cast<int>(frequency * pointRatio * binsPerHz)));
+        }
+    }
+
+    void computeSpectrum(float elapsedSeconds)
+    {
+        // Ultimi fftSize campioni in ordine cronologico
+        for (int i = 0; i < fftSize; ++i)
+            fftData[(size_t)i] = history[(size_t)((historyPosition + i) % fftSize)];
+
+        window.multiplyWithWindowingTable(fftData.data(), static_cast<size_t>(fftSize));
+        fft.performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+        // Hann: il picco di una sinusoide di ampiezza A vale A * fftSize / 4
+        const float amplitudeScale = 4.0f / static_cast<float>(fftSize);
+        const float release = releaseDbPerSecond * elapsedSeconds;
+        auto& output = spectrum.getWriteBuffer();
+
+        for (int i = 0; i < numPoints; ++i)
+        {
+            float peak = 0.0f;
+            for (int bin = firstBin[(size_t)i]; bin <= lastBin[(size_t)i]; ++bin)
+                peak = juce::jmax(peak, fftData[(size_t)bin]);
+
+            const float db = juce::Decibels::gainToDecibels(peak * amplitudeScale, floorDb);
+            levels[(size_t)i] = juce::jmax(db, levels[(size_t)i] - release);
+            output[(size_t)i] = levels[(size_t)i];
+        }
+
+        spectrum.publish();
+    }
+
+    // ====== Thread dei messaggi ======
+    struct FilterKey
+    {
+        double sampleRate = 0;
+        float cutoff = 0, quality = 0;
+        int type = -1;
+        bool active = false;
+
+        bool operator==(const FilterKey& other) const noexcept
+        {
+            return juce::approximatelyEqual(sampleRate, other.sampleRate) && juce::approximatelyEqual(cutoff, other.cutoff)
+                && juce::approximatelyEqual(quality, other.quality) && type == other.type && active == other.active;
+        }
+    };
+
+    // true se la risposta è stata ricalcolata
+    bool updateFilterResponse()
+    {
+        // Il filtro gira alla frequenza sovracampionata
+        FilterKey key;
+        key.sampleRate = tap.getSampleRate() * (1 << juce::roundToInt(oversampling->load()));
+        key.cutoff = filterCutoff->load();
+        key.quality = filterQuality->load();
+        key.type = juce::roundToInt(filterType->load());
+        key.active = filterActive->load() > 0.5f;
+
+        if (key == responseKey)
+            return false;
+
+        responseKey = key;
+
+        if (key.active)
+            StereoFilter<double>::getMagnitudeResponse(key.sampleRate, key.cutoff, key.quality, key.type,
+                frequencies.data(), response.data(), numPoints);
+
+        return true;
+    }
+
+    static float frequencyToX(juce::Rectangle<float> area, float frequency) noexcept
+    {
+        return area.getX() + area.getWidth() * std::log(frequency / minFrequency) / std::log(maxFrequency / minFrequency);
+    }
+
+    static float dbToY(juce::Rectangle<float> area, float db) noexcept
+    {
+        return juce::jmap(juce::jlimit(minDb, maxDb, db), minDb, maxDb, area.getBottom(), area.getY());
+    }
+
+    static Spectrum makeFloor() noexcept
+    {
+        Spectrum floor;
+        floor.fill(floorDb);
+        return floor;
+    }
+
+    // Sotto il bordo inferiore del grafico
+    static constexpr float floorDb = minDb - 12.0f;
+
+    SpectrumTap& tap;
+    juce::SharedResourcePointer<AnalyzerThread> analyzerThread;
+
+    // Thread di analisi
+    juce::dsp::FFT fft;
+    juce::dsp::WindowingFunction<float> window;
+    std::array<float, fftSize> history{};
+    std::array<float, fftSize * 2> fftData{};
+    std::array<float, 2048> readBuffer{};
+    std::array<int, numPoints> firstBin{}, lastBin{};
+    Spectrum levels{};
+    double analysisSampleRate = 0;
+    int historyPosition = 0, samplesSinceSpectrum = 0;
+
+    TripleBuffer<Spectrum> spectrum;
+
+    // Entrambi (solo lettura dopo il costruttore)
+    std::array<double, numPoints> frequencies{};
+
+    // Thread dei messaggi
+    std::atomic<float>* filterActive = nullptr;
+    std::atomic<float>* filterType = nullptr;
+    std::atomic<float>* filterCutoff = nullptr;
+    std::atomic<float>* filterQuality = nullptr;
+    std::atomic<float>* oversampling = nullptr;
+    FilterKey responseKey;
+    std::array<double, numPoints> response{};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyzer)
+};
@@ -1,9 +1,7 @@
 #pragma once
 #include <JuceHeader.h>
-
-#ifndef MAX_DELAY_TIME
-#define MAX_DELAY_TIME 10.0 // secondi
-#endif
+#include "PluginParameters.h"
+#include "Smoothing.h"
 
 #ifndef DEFAULT_FEEDBACK
 #define DEFAULT_FEEDBACK 0.3f
@@ -13,10 +11,34 @@
 #define DEFAULT_DELAY_TIME 5.0 // ms
 #endif
 
+// Escursione massima: offset base del delay + Delay Time massimo + profondità dell'LFO
+#ifndef MAX_DELAY_TIME
+#define MAX_DELAY_TIME ((DEFAULT_DELAY_TIME + Parameters::maxDelayTime + Parameters::maxModAmount) * 0.001) // secondi
+#endif
+
+// Campioni di margine nel ring buffer per il kernel di interpolazione più lungo
+#ifndef INTERPOLATION_GUARD
+#define INTERPOLATION_GUARD 8
+#endif
+
+// SampleType (float/double): memoria, interpolazione e calcolo del ritardo nello stesso tipo.
+// Il ritardo è diviso in parte intera e frazionaria prima di sottrarlo all'indice di scrittura,
+// così la frazione resta precisa anche in float.
+// Numero di canali qualsiasi (fissato in prepareToPlay): ogni canale ha la sua linea e il suo stato,
+// i percorsi a blocchi elaborano un canale alla volta per tutto il blocco.
+// Con la linea condivisa (ingresso mono, uscita stereo) c'è una sola linea, letta a una presa
+// modulata per canale.
+// Multi-voce (setNumVoices): ogni uscita legge la sua linea a numVoices prese modulate e ne fa
+// la media, una sola scrittura per linea e per frame. Le prese sono indicizzate per uscita e voce
+// (presa = uscita * numVoices + voce), con stato dell'allpass e traiettoria propri
+template <typename SampleType>
 class Delays
 {
 public:
-    Delays(double defaultDelayTime = DEFAULT_DELAY_TIME, float defaultFeedback = DEFAULT_FEEDBACK)
+    // Interpolatori del ritardo frazionario (stesso ordine del parametro "interpolation")
+    enum Interpolation { Linear = 0, Hermite, Lagrange3, Thiran, Sinc };
+
+    Delays(SampleType defaultDelayTime = static_cast<SampleType>(DEFAULT_DELAY_TIME), SampleType defaultFeedback = static_cast<SampleType>(DEFAULT_FEEDBACK))
     {
         delayTime.setCurrentAndTargetValue(defaultDelayTime);
         feedback.setCurrentAndTargetValue(defaultFeedback);
@@ -24,92 +46,770 @@ public:
 
     ~Delays() {}
 
-    void prepareToPlay(double newSampleRate, int maxNumSamples)
+    // maxOversamplingFactor: la memoria è allocata per il sample rate massimo, poi
+    // setSampleRate cambia frequenza senza allocare.
+    // shouldShareLine: una sola linea alimentata dal canale 0, numChannels prese in uscita
+    void prepareToPlay(double newSampleRate, int numChannels, int maxNumSamples, int maxOversamplingFactor = 1, bool shouldShareLine = false)
+    {
+        jassert(numChannels >= 1 && maxOversamplingFactor >= 1);
+
+        sharedLine = shouldShareLine;
+        delayMemory.setSize(sharedLine ? 1 : numChannels, getRequiredMemorySize(newSampleRate * maxOversamplingFactor));
+
+        for (auto* state : { &thiranState, &lastModulationMs, &segmentStartMs, &segmentStepMs })
+            state->assign(static_cast<size_t>(numChannels * Parameters::maxVoices), SampleType(0));
+
+        delayTime.setMaximumBlockSize(maxNumSamples);
+        feedback.setMaximumBlockSize(maxNumSamples);
+        getSincTable(); // tabella costruita fuori dal thread audio
+
+        setSampleRate(newSampleRate);
+    }
+
+    // Cambia sample rate (es. fattore di oversampling) senza allocare: azzera la memoria
+    void setSampleRate(double newSampleRate)
     {
         sampleRate = newSampleRate;
-        memorySize = static_cast<int>(MAX_DELAY_TIME * sampleRate) + maxNumSamples;
 
-        delayMemory.setSize(2, memorySize);
-        delayMemory.clear();
+        // Ring buffer potenza di due: il wrap degli indici è una maschera
+        memorySize = getRequiredMemorySize(sampleRate);
+        memoryMask = memorySize - 1;
+
+        jassert(memorySize <= delayMemory.getNumSamples());
+
+        samplesPerMs = static_cast<SampleType>(sampleRate * 0.001);
 
         delayTime.reset(sampleRate, 0.030);   // 30ms smoothing
         feedback.reset(sampleRate, 0.020);    // 20ms smoothing
 
         writeIndex = 0;
-        oldSample[0] = oldSample[1] = 0.0f;
+        clear();
+    }
+
+    // Azzera memoria e stato degli interpolatori (senza allocare)
+    void clear()
+    {
+        delayMemory.clear();
+
+        std::fill(thiranState.begin(), thiranState.end(), SampleType(0));
+        std::fill(lastModulationMs.begin(), lastModulationMs.end(), SampleType(0));
+        modulationPrimed = false;
     }
 
+    // Avanza di numSamples campioni senza elaborare (memoria già a zero):
+    // smoothing e indice di scrittura restano allineati al tempo
+    void skip(int numSamples)
+    {
+        delayTime.skip(numSamples);
+        feedback.skip(numSamples);
+        writeIndex = (writeIndex + numSamples) & memoryMask;
+        modulationPrimed = false;
+    }
+
+    // Alimenta la memoria senza produrre uscita (mix tutto dry): ingresso + feedback letto a
+    // ritardo intero, fermo per il blocco (modulationMs: modulazione corrente per presa, numVoices
+    // per uscita). La memoria resta coerente con il ricircolo, al ritorno del wet non ci sono salti
+    void pushInput(const juce::AudioBuffer<SampleType>& input, const SampleType* modulationMs)
+    {
+        const int numSamples = input.getNumSamples();
+        const int numOutputs = sharedLine ? numSharedTaps : juce::jmin(input.getNumChannels(), delayMemory.getNumChannels());
+
+        forEachLine(numOutputs, [&](int line, int firstOutput, int lineOutputs)
+            {
+                pushLine(line, input.getReadPointer(line), numSamples, modulationMs + firstOutput * numVoices, lineOutputs * numVoices);
+            });
+
+        skip(numSamples);
+        std::fill(thiranState.begin(), thiranState.end(), SampleType(0));
+    }
+
+    // Una linea: in feedback la media delle sue numTaps prese, come in processTaps e processVoices
+    void pushLine(int line, const SampleType* source, int numSamples, const SampleType* modulationMs, int numTaps)
+    {
+        const SampleType feedbackGain = feedback.getCurrentValue() / static_cast<SampleType>(numTaps);
+
+        int delaySamples[numSharedTaps * Parameters::maxVoices];
+        for (int tap = 0; tap < numTaps; ++tap)
+            delaySamples[tap] = juce::jlimit(1, memorySize - INTERPOLATION_GUARD, juce::roundToInt((delayTime.getCurrentValue() + modulationMs[tap]) * samplesPerMs));
+
+        auto* delayData = delayMemory.getWritePointer(line);
+
+        for (int s = 0, w = writeIndex; s < numSamples; ++s, w = (w + 1) & memoryMask)
+        {
+            SampleType sum = delayData[(w - delaySamples[0]) & memoryMask];
+            for (int tap = 1; tap < numTaps; ++tap)
+                sum += delayData[(w - delaySamples[tap]) & memoryMask];
+
+            delayData[w] = source[s] + feedbackGain * sum;
+        }
+    }
+
+    // Picco del contenuto della memoria (decadimento della coda)
+    SampleType getPeakLevel() const
+    {
+        SampleType peak = 0;
+        for (int ch = 0; ch < delayMemory.getNumChannels(); ++ch)
+            peak = juce::jmax(peak, delayMemory.getMagnitude(ch, 0, memorySize));
+
+        return peak;
+    }
+
+    // Massima differenza tra lo stato di due canali (memoria e stato dell'allpass di Thiran di ogni voce)
+    SampleType getChannelDifference(int a, int b) const
+    {
+        const SampleType* x = delayMemory.getReadPointer(a);
+        const SampleType* y = delayMemory.getReadPointer(b);
+        SampleType difference = 0;
+
+        for (int v = 0; v < numVoices; ++v)
+            difference = juce::jmax(difference, std::abs(thiranState[(size_t)(a * numVoices + v)] - thiranState[(size_t)(b * numVoices + v)]));
+
+        for (int i = 0; i < memorySize; ++i)
+            difference = juce::jmax(difference, std::abs(x[i] - y[i]));
+
+        return difference;
+    }
+
+    // Il canale destination riprende lo stato di source (memoria, allpass, traiettoria della modulazione)
+    void copyChannelState(int source, int destination)
+    {
+        delayMemory.copyFrom(destination, 0, delayMemory, source, 0, memorySize);
+
+        for (auto* state : { &thiranState, &lastModulationMs, &segmentStartMs, &segmentStepMs })
+            for (int v = 0; v < numVoices; ++v)
+                (*state)[(size_t)(destination * numVoices + v)] = (*state)[(size_t)(source * numVoices + v)];
+    }
+
+    int getMemorySize() const noexcept { return memorySize; }
+    SampleType getDelayTime() const noexcept { return delayTime.getTargetValue(); }
+
     void releaseResources()
     {
         delayMemory.setSize(0, 0);
         memorySize = 0;
+        memoryMask = 0;
     }
 
-    // Process con modulazione stereo
-    void processBlock(juce::AudioBuffer<float>& buffer, const juce::AudioBuffer<float>& modulation)
+    // Memoria allocata per il ring buffer, in byte
+    size_t getMemoryFootprint() const noexcept
+    {
+        return static_cast<size_t>(delayMemory.getNumChannels()) * static_cast<size_t>(delayMemory.getNumSamples()) * sizeof(SampleType);
+    }
+
+    // Process con modulazione per canale (ms, un valore per campione)
+    void processBlock(juce::AudioBuffer<SampleType>& buffer, const juce::AudioBuffer<SampleType>& modulation)
     {
         const int numCh = buffer.getNumChannels();
         const int numSamples = buffer.getNumSamples();
 
-        jassert(modulation.getNumChannels() == numCh);
+        jassert(sharedLine ? numCh == numSharedTaps : numCh <= delayMemory.getNumChannels());
+        jassert(modulation.getNumChannels() == numCh * numVoices);
         jassert(modulation.getNumSamples() == numSamples);
 
         auto bufferData = buffer.getArrayOfWritePointers();
-        auto delayData = delayMemory.getArrayOfWritePointers();
+        auto modulationData = modulation.getArrayOfReadPointers();
 
-        for (int s = 0; s < numSamples; ++s)
-        {
-            for (int ch = 0; ch < numCh; ++ch)
+        // Smoothing avanzato una volta per frame, non per canale
+        const auto delayBlock = delayTime.process(numSamples);
+        const auto feedbackBlock = feedback.process(numSamples);
+
+        // Interpolatore e varianti costante/rampa scelti una volta per blocco
+        withInterpolation([&](auto kernel)
             {
-                // Delay modulato (ms -> samples)
-                double dtSamples = delayTime.getNextValue() * 0.001 * sampleRate
-                    + modulation.getReadPointer(ch)[s] * sampleRate * 0.001;
-                dtSamples = juce::jlimit(0.0, static_cast<double>(memorySize - 2), dtSamples);
+                constexpr auto type = decltype(kernel)::value;
+
+                visitSmoothedBlocks(delayBlock, feedbackBlock, [&](auto delayMs, auto feedbackGain)
+                    {
+                        if (numVoices > 1)
+                        {
+                            forEachLine(numCh, [&](int line, int firstOutput, int numOutputs)
+                                {
+                                    processVoices<type>(line, bufferData + firstOutput, numOutputs, firstOutput * numVoices, 0, numSamples,
+                                        writeIndex, delayMs, feedbackGain, [modulationData](int tap, int s) { return modulationData[tap][s]; });
+                                });
+
+                            for (int tap = 0; tap < numCh * numVoices; ++tap)
+                                lastModulationMs[(size_t)tap] = modulationData[tap][numSamples - 1];
+
+                            return;
+                        }
+
+                        if (sharedLine)
+                        {
+                            processTaps<type>(bufferData, 0, numSamples, writeIndex, delayMs, feedbackGain,
+                                [modulationData](int tap, int s) { return modulationData[tap][s]; });
+
+                            for (int tap = 0; tap < numSharedTaps; ++tap)
+                                lastModulationMs[(size_t)tap] = modulationData[tap][numSamples - 1];
+
+                            return;
+                        }
+
+                        for (int ch = 0; ch < numCh; ++ch)
+                        {
+                            const SampleType* channelModulation = modulationData[ch];
+                            processRun<type>(ch, bufferData[ch], 0, numSamples, writeIndex, delayMs, feedbackGain,
+                                [channelModulation](int s) { return channelModulation[s]; });
+
+                            lastModulationMs[(size_t)ch] = channelModulation[numSamples - 1];
+                        }
+                    });
+            });
+
+        writeIndex = (writeIndex + numSamples) & memoryMask;
+    }
+
+    // Process con modulazione a control rate: controlPoints[ch][k] è il valore (ms) all'ultimo
+    // campione del k-esimo segmento di controlInterval campioni, interpolato linearmente
+    void processBlock(juce::AudioBuffer<SampleType>& buffer, const juce::AudioBuffer<SampleType>& controlPoints, int controlInterval)
+    {
+        const int numCh = buffer.getNumChannels();
+        const int numSamples = buffer.getNumSamples();
+
+        jassert(sharedLine ? numCh == numSharedTaps : numCh <= delayMemory.getNumChannels());
+        jassert(controlPoints.getNumChannels() == numCh * numVoices);
+        jassert(controlInterval >= 1);
+
+        auto bufferData = buffer.getArrayOfWritePointers();
+        auto controlData = controlPoints.getArrayOfReadPointers();
+
+        const auto delayBlock = delayTime.process(numSamples);
+        const auto feedbackBlock = feedback.process(numSamples);
+
+        withInterpolation([&](auto kernel)
+            {
+                constexpr auto type = decltype(kernel)::value;
+
+                visitSmoothedBlocks(delayBlock, feedbackBlock, [&](auto delayMs, auto feedbackGain)
+                    {
+                        if (numVoices > 1)
+                        {
+                            // Un segmento alla volta per tutte le linee (stesso indice di scrittura a inizio segmento)
+                            const int numTaps = numCh * numVoices;
+
+                            for (int start = 0, k = 0; start < numSamples; start += controlInterval, ++k)
+                            {
+                                const int length = juce::jmin(controlInterval, numSamples - start);
+                                beginModulationSegmentAt([controlData, k](int tap) { return controlData[tap][k]; }, numTaps, length);
+
+                                forEachLine(numCh, [&](int line, int firstOutput, int numOutputs)
+                                    {
+                                        processVoices<type>(line, bufferData + firstOutput, numOutputs, firstOutput * numVoices, start, length,
+                                            (writeIndex + start) & memoryMask, delayMs, feedbackGain,
+                                            [this, start](int tap, int s) { return getSegmentModulation(tap, s - start + 1); });
+                                    });
+
+                                for (int tap = 0; tap < numTaps; ++tap)
+                                    lastModulationMs[(size_t)tap] = getSegmentModulation(tap, length);
+                            }
+
+                            return;
+                        }
+
+                        if (sharedLine)
+                        {
+                            for (int start = 0, k = 0, w = writeIndex; start < numSamples; start += controlInterval, ++k)
+                            {
+                                const int length = juce::jmin(controlInterval, numSamples - start);
+
+                                const SampleType targetMs[numSharedTaps] = { controlData[0][k], controlData[1][k] };
+                                beginModulationSegment(targetMs, numSharedTaps, length);
+
+                                w = processTaps<type>(bufferData, start, length, w, delayMs, feedbackGain,
+                                    [this, start](int tap, int s) { return getSegmentModulation(tap, s - start + 1); });
+
+                                for (int tap = 0; tap < numSharedTaps; ++tap)
+                                    lastModulationMs[(size_t)tap] = getSegmentModulation(tap, length);
+                            }
+
+                            return;
+                        }
+
+                        for (int ch = 0; ch < numCh; ++ch)
+                        {
+                            SampleType from = modulationPrimed ? lastModulationMs[(size_t)ch] : controlData[ch][0];
+
+                            for (int start = 0, k = 0, w = writeIndex; start < numSamples; start += controlInterval, ++k)
+                            {
+                                const int length = juce::jmin(controlInterval, numSamples - start);
+                                const SampleType step = (controlData[ch][k] - from) / static_cast<SampleType>(length);
+
+                                // Campione position (1..length) del segmento: from + step * position
+                                w = processRun<type>(ch, bufferData[ch], start, length, w, delayMs, feedbackGain,
+                                    [from, step, start](int s) { return from + step * static_cast<SampleType>(s - start + 1); });
+
+                                from = from + step * static_cast<SampleType>(length);
+                            }
+
+                            lastModulationMs[(size_t)ch] = from;
+                        }
+                    });
+            });
+
+        modulationPrimed = modulationPrimed || numSamples > 0;
+        writeIndex = (writeIndex + numSamples) & memoryMask;
+    }
+
+    // Nuovo segmento di length campioni: la modulazione va dall'ultimo valore usato a targetMs
+    inline void beginModulationSegment(const SampleType* targetMs, int numChannels, int length) noexcept
+    {
+        beginModulationSegmentAt([targetMs](int ch) { return targetMs[ch]; }, numChannels, length);
+    }
+
+    // Come sopra, con il valore di arrivo del canale (o della presa) ch dato da targetAt(ch)
+    template <typename TargetAt>
+    inline void beginModulationSegmentAt(TargetAt targetAt, int numChannels, int length) noexcept
+    {
+        jassert(numChannels <= static_cast<int>(segmentStartMs.size()));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const SampleType target = targetAt(ch);
+            const SampleType from = modulationPrimed ? lastModulationMs[(size_t)ch] : target;
+            segmentStartMs[(size_t)ch] = from;
+            segmentStepMs[(size_t)ch] = (target - from) / static_cast<SampleType>(length);
+        }
+
+        modulationPrimed = true;
+    }
+
+    // Modulazione interpolata al campione position (1..length) del segmento corrente
+    inline SampleType getSegmentModulation(int ch, int position) const noexcept
+    {
+        return segmentStartMs[(size_t)ch] + segmentStepMs[(size_t)ch] * static_cast<SampleType>(position);
+    }
+
+    // Percorso per-campione (fuso): avanza lo smoothing di delay time e feedback,
+    // una volta per frame prima di processSample() sui canali
+    inline void beginSample() noexcept
+    {
+        frameDelayMs = delayTime.getNextValue();
+        frameFeedback = feedback.getNextValue();
+    }
+
+    // Un campione di un canale: scrive l'ingresso, legge il ritardo modulato (ms) e applica il feedback.
+    // Dopo aver processato tutti i canali di un frame va chiamato advanceWriteIndex().
+    // Versione per-campione (percorso fuso): lo switch sull'interpolatore è sempre lo stesso ramo
+    inline SampleType processSample(int ch, SampleType input, SampleType modulationMs) noexcept
+    {
+        switch (interpolation)
+        {
+        case Hermite:   return processSample<Hermite>(ch, input, modulationMs, frameDelayMs, frameFeedback);
+        case Lagrange3: return processSample<Lagrange3>(ch, input, modulationMs, frameDelayMs, frameFeedback);
+        case Thiran:    return processSample<Thiran>(ch, input, modulationMs, frameDelayMs, frameFeedback);
+        case Sinc:      return processSample<Sinc>(ch, input, modulationMs, frameDelayMs, frameFeedback);
+        case Linear:
+        default:        return processSample<Linear>(ch, input, modulationMs, frameDelayMs, frameFeedback);
+        }
+    }
+
+    // Linea condivisa, per-campione (percorso fuso): scrive l'ingresso mono e legge le due prese
+    // (una per canale) in outputs. Anche qui dopo il frame va chiamato advanceWriteIndex()
+    inline void processTaps(SampleType input, const SampleType* modulationMs, SampleType* outputs) noexcept
+    {
+        switch (interpolation)
+        {
+        case Hermite:   processTaps<Hermite>(input, modulationMs, outputs); break;
+        case Lagrange3: processTaps<Lagrange3>(input, modulationMs, outputs); break;
+        case Thiran:    processTaps<Thiran>(input, modulationMs, outputs); break;
+        case Sinc:      processTaps<Sinc>(input, modulationMs, outputs); break;
+        case Linear:
+        default:        processTaps<Linear>(input, modulationMs, outputs); break;
+        }
+    }
+
+    template <Interpolation type>
+    inline void processTaps(SampleType input, const SampleType* modulationMs, SampleType* outputs) noexcept
+    {
+        jassert(sharedLine);
+
+        auto* delayData = delayMemory.getWritePointer(0);
+        delayData[writeIndex] = input;
+
+        for (int tap = 0; tap < numSharedTaps; ++tap)
+        {
+            outputs[tap] = readTap<type>(tap, delayData, writeIndex, frameDelayMs + modulationMs[tap]);
+            lastModulationMs[(size_t)tap] = modulationMs[tap];
+        }
+
+        delayData[writeIndex] += (outputs[0] + outputs[1]) * static_cast<SampleType>(0.5) * frameFeedback;
+    }
+
+    template <Interpolation type>
+    inline SampleType processSample(int ch, SampleType input, SampleType modulationMs, SampleType delayMs, SampleType feedbackGain) noexcept
+    {
+        auto* delayData = delayMemory.getWritePointer(ch);
+
+        // Delay modulato (ms -> samples), limitato al minimo richiesto dal kernel
+        SampleType dtSamples = (delayMs + modulationMs) * samplesPerMs;
+        dtSamples = juce::jlimit(getMinimumDelay(type), static_cast<SampleType>(memorySize - INTERPOLATION_GUARD), dtSamples);
+
+        // writeIndex - dt = (writeIndex - intero - 1) + (1 - frazione): il punto letto è tra
+        // idx0 e idx0 + 1 (frac = 1 per ritardi interi, ogni kernel restituisce idx0 + 1)
+        const int wholeDelay = static_cast<int>(dtSamples);
+        const int idx0 = (writeIndex - wholeDelay - 1) & memoryMask;
+        const SampleType frac = 1 - (dtSamples - static_cast<SampleType>(wholeDelay));
 
-                double readIndex = writeIndex - dtSamples;
-                if (readIndex < 0.0)
-                    readIndex += memorySize;
+        // Scrittura input nel buffer delay
+        delayData[writeIndex] = input;
 
-                int idx0 = static_cast<int>(readIndex);
-                int idx1 = (idx0 + 1) % memorySize;
-                double frac = readIndex - idx0;
+        const SampleType delayedSample = interpolate<type>(ch, delayData, idx0, frac);
 
-                // Scrittura input nel buffer delay
-                delayData[ch][writeIndex] = bufferData[ch][s];
+        // Feedback
+        delayData[writeIndex] += delayedSample * feedbackGain;
 
-                // Interpolazione lineare
-                float delayedSample = static_cast<float>(
-                    delayData[ch][idx0] * (1.0 - frac) +
-                    delayData[ch][idx1] * frac
-                    );
+        lastModulationMs[(size_t)ch] = modulationMs;
 
-                // Feedback
-                delayData[ch][writeIndex] += delayedSample * feedback.getNextValue();
+        return delayedSample;
+    }
+
+    // Percorsi a blocchi: un canale per length campioni da start, con l'indice di scrittura in locale
+    // (parte da w, restituisce quello successivo). Stessi calcoli di processSample, ma memoria,
+    // maschera e indice restano nei registri per tutto il run invece di essere riletti a ogni campione
+    template <Interpolation type, typename DelayValues, typename FeedbackValues, typename ModulationAt>
+    inline int processRun(int ch, SampleType* data, int start, int length, int w,
+        DelayValues delayMs, FeedbackValues feedbackGain, ModulationAt modulationAt) noexcept
+    {
+        SampleType* delayData = delayMemory.getWritePointer(ch);
+        const int mask = memoryMask;
+        const SampleType spm = samplesPerMs;
+        const SampleType maxDelay = static_cast<SampleType>(memorySize - INTERPOLATION_GUARD);
+
+        for (int s = start; s < start + length; ++s)
+        {
+            const SampleType dtSamples = juce::jlimit(getMinimumDelay(type), maxDelay, (delayMs[s] + modulationAt(s)) * spm);
+
+            const int wholeDelay = static_cast<int>(dtSamples);
+            const int idx0 = (w - wholeDelay - 1) & mask;
+            const SampleType frac = 1 - (dtSamples - static_cast<SampleType>(wholeDelay));
+
+            delayData[w] = data[s];
+            const SampleType delayedSample = interpolate<type>(ch, delayData, idx0, frac);
+            delayData[w] += delayedSample * feedbackGain[s];
+
+            data[s] = delayedSample;
+            w = (w + 1) & mask;
+        }
+
+        return w;
+    }
+
+    // Linea condivisa a blocchi: a ogni frame l'ingresso (data[0]) entra nella linea, i due canali
+    // leggono ciascuno la sua presa modulata e in feedback torna la media delle prese
+    template <Interpolation type, typename DelayValues, typename FeedbackValues, typename ModulationAt>
+    inline int processTaps(SampleType* const* data, int start, int length, int w,
+        DelayValues delayMs, FeedbackValues feedbackGain, ModulationAt modulationAt) noexcept
+    {
+        SampleType* delayData = delayMemory.getWritePointer(0);
+        SampleType* left = data[0];
+        SampleType* right = data[1];
+        const int mask = memoryMask;
+
+        for (int s = start; s < start + length; ++s)
+        {
+            delayData[w] = left[s];
 
-                // Aggiorna output
-                bufferData[ch][s] = delayedSample;
+            const SampleType tap0 = readTap<type>(0, delayData, w, delayMs[s] + modulationAt(0, s));
+            const SampleType tap1 = readTap<type>(1, delayData, w, delayMs[s] + modulationAt(1, s));
 
-                // Salva per eventuale uso
-                oldSample[ch] = delayedSample;
+            delayData[w] += (tap0 + tap1) * static_cast<SampleType>(0.5) * feedbackGain[s];
+            left[s] = tap0;
+            right[s] = tap1;
+            w = (w + 1) & mask;
+        }
+
+        return w;
+    }
+
+    // Multi-voce a blocchi: a ogni frame l'ingresso (outputs[0]) entra nella linea, ogni uscita legge le sue
+    // numVoices prese (da firstTap in poi) e ne prende la media, in feedback torna la media di tutte le prese
+    template <Interpolation type, typename DelayValues, typename FeedbackValues, typename ModulationAt>
+    inline int processVoices(int line, SampleType* const* outputs, int numOutputs, int firstTap, int start, int length, int w,
+        DelayValues delayMs, FeedbackValues feedbackGain, ModulationAt modulationAt) noexcept
+    {
+        SampleType* delayData = delayMemory.getWritePointer(line);
+        const int mask = memoryMask;
+        const int voices = numVoices;
+        const SampleType spm = samplesPerMs;
+        const SampleType maxDelay = static_cast<SampleType>(memorySize - INTERPOLATION_GUARD);
+        const SampleType voiceGain = 1 / static_cast<SampleType>(voices);
+        const SampleType tapGain = voiceGain / static_cast<SampleType>(numOutputs);
+
+        for (int s = start; s < start + length; ++s)
+        {
+            delayData[w] = outputs[0][s];
+            const SampleType frameDelayMs = delayMs[s];
+            SampleType total = 0;
+
+            for (int out = 0, tap = firstTap; out < numOutputs; ++out)
+            {
+                SampleType sum = 0;
+                for (int v = 0; v < voices; ++v, ++tap)
+                {
+                    const SampleType dtSamples = juce::jlimit(getMinimumDelay(type), maxDelay, (frameDelayMs + modulationAt(tap, s)) * spm);
+                    const int wholeDelay = static_cast<int>(dtSamples);
+
+                    sum += interpolate<type>(tap, delayData, (w - wholeDelay - 1) & mask, 1 - (dtSamples - static_cast<SampleType>(wholeDelay)));
+                }
+
+                outputs[out][s] = sum * voiceGain;
+                total += sum;
             }
 
-            writeIndex = (writeIndex + 1) % memorySize;
+            delayData[w] += total * tapGain * feedbackGain[s];
+            w = (w + 1) & mask;
         }
+
+        return w;
+    }
+
+    // Presa della linea condivisa o di una voce: ritardo totale (ms) letto prima dell'indice di scrittura w
+    template <Interpolation type>
+    inline SampleType readTap(int tap, const SampleType* delayData, int w, SampleType totalDelayMs) noexcept
+    {
+        const SampleType dtSamples = juce::jlimit(getMinimumDelay(type), static_cast<SampleType>(memorySize - INTERPOLATION_GUARD), totalDelayMs * samplesPerMs);
+
+        const int wholeDelay = static_cast<int>(dtSamples);
+        const int idx0 = (w - wholeDelay - 1) & memoryMask;
+        const SampleType frac = 1 - (dtSamples - static_cast<SampleType>(wholeDelay));
+
+        return interpolate<type>(tap, delayData, idx0, frac);
+    }
+
+    // Ritardo minimo (campioni) per cui il kernel legge solo campioni già scritti
+    static constexpr SampleType getMinimumDelay(Interpolation type) noexcept
+    {
+        return static_cast<SampleType>(type == Sinc ? sincTaps / 2 : (type == Linear ? 0 : 2));
+    }
+
+    inline void advanceWriteIndex() noexcept
+    {
+        writeIndex = (writeIndex + 1) & memoryMask;
+    }
+
+    void setDelayTime(SampleType newValue) { delayTime.setTargetValue(newValue); }
+    void setFeedback(SampleType newValue) { feedback.setTargetValue(newValue); }
+
+    // Delay time e feedback saltano al target (cambio di preset a uscita muta)
+    void snapToTargets() noexcept
+    {
+        delayTime.snapToTarget();
+        feedback.snapToTarget();
+    }
+
+    void setInterpolation(int newInterpolation)
+    {
+        interpolation = static_cast<Interpolation>(juce::jlimit(0, static_cast<int>(Sinc), newInterpolation));
     }
 
-    void setDelayTime(double newValue) { delayTime.setTargetValue(newValue); }
-    void setFeedback(float newValue) { feedback.setTargetValue(newValue); }
+    Interpolation getInterpolation() const noexcept { return interpolation; }
+
+    // Prese sulla linea condivisa (ingresso mono, uscita stereo)
+    static constexpr int numSharedTaps = 2;
+    bool isSharedLine() const noexcept { return sharedLine; }
+
+    // Voci per uscita (1..Parameters::maxVoices): con più di una voce la modulazione ha un canale per
+    // presa e il percorso per-campione non è disponibile. La memoria resta, lo stato delle prese riparte
+    void setNumVoices(int newNumVoices) noexcept
+    {
+        newNumVoices = juce::jlimit(1, Parameters::maxVoices, newNumVoices);
+        if (newNumVoices == numVoices)
+            return;
+
+        numVoices = newNumVoices;
+        std::fill(thiranState.begin(), thiranState.end(), SampleType(0));
+        modulationPrimed = false;
+    }
+
+    int getNumVoices() const noexcept { return numVoices; }
 
 private:
+    template <Interpolation type>
+    using InterpolationTag = std::integral_constant<Interpolation, type>;
+
+    // Linee da elaborare: process(linea, prima uscita, numero di uscite). Una per canale, oppure la
+    // linea condivisa con entrambe le uscite
+    template <typename Function>
+    void forEachLine(int numCh, Function&& process)
+    {
+        if (sharedLine)
+            process(0, 0, numCh);
+        else
+            for (int ch = 0; ch < numCh; ++ch)
+                process(ch, ch, 1);
+    }
+
+    // Chiama process con il tipo di interpolatore corrente come costante di compilazione
+    template <typename Function>
+    void withInterpolation(Function&& process)
+    {
+        switch (interpolation)
+        {
+        case Hermite:   process(InterpolationTag<Hermite>{}); break;
+        case Lagrange3: process(InterpolationTag<Lagrange3>{}); break;
+        case Thiran:    process(InterpolationTag<Thiran>{}); break;
+        case Sinc:      process(InterpolationTag<Sinc>{}); break;
+        case Linear:
+        default:        process(InterpolationTag<Linear>{}); break;
+        }
+    }
+
+    // ====== Kernel di interpolazione ======
+    // Il punto letto è tra idx0 (più vecchio) e idx0 + 1, a distanza frac da idx0
+    template <Interpolation type>
+    inline SampleType interpolate(int ch, const SampleType* data, int idx0, SampleType frac) noexcept
+    {
+        auto at = [data, this](int index) { return data[index & memoryMask]; };
+
+        constexpr auto half = static_cast<SampleType>(0.5);
+        constexpr auto sixth = static_cast<SampleType>(1.0 / 6.0);
+
+        if constexpr (type == Linear)
+        {
+            return data[idx0] * (1 - frac) + at(idx0 + 1) * frac;
+        }
+        else if constexpr (type == Hermite)
+        {
+            // Catmull-Rom a 4 punti
+            const SampleType t = frac;
+            const SampleType xm1 = at(idx0 - 1), x0 = data[idx0], x1 = at(idx0 + 1), x2 = at(idx0 + 2);
+
+            const SampleType c1 = half * (x1 - xm1);
+            const SampleType c2 = xm1 - static_cast<SampleType>(2.5) * x0 + 2 * x1 - half * x2;
+            const SampleType c3 = half * (x2 - xm1) + static_cast<SampleType>(1.5) * (x0 - x1);
+
+            return ((c3 * t + c2) * t + c1) * t + x0;
+        }
+        else if constexpr (type == Lagrange3)
+        {
+            // Lagrange del terzo ordine sui punti -1, 0, 1, 2
+            const SampleType t = frac;
+            const SampleType tp1 = t + 1, tm1 = t - 1, tm2 = t - 2;
+
+            return at(idx0 - 1) * (-t * tm1 * tm2 * sixth)
+                 + data[idx0]   * (tp1 * tm1 * tm2 * half)
+                 + at(idx0 + 1) * (-tp1 * t * tm2 * half)
+                 + at(idx0 + 2) * (tp1 * t * tm1 * sixth);
+        }
+        else if constexpr (type == Thiran)
+        {
+            // Allpass di Thiran del primo ordine: ritardo frazionario delta dal campione newer,
+            // portato in [0.618, 1.618) dove la risposta di fase è più lineare
+            SampleType delta = 1 - frac;
+            const bool shift = delta < static_cast<SampleType>(0.618);
+            const int newer = idx0 + (shift ? 2 : 1);
+            delta += shift ? 1 : 0;
+
+            const SampleType alpha = (1 - delta) / (1 + delta);
+            const SampleType output = at(newer - 1) + alpha * (at(newer) - thiranState[(size_t)ch]);
+
+            thiranState[(size_t)ch] = output;
+            return output;
+        }
+        else
+        {
+            // Sinc finestrata a sincTaps punti (da idx0 - 3 a idx0 + 4), coefficienti
+            // interpolati linearmente tra due fasi della tabella
+            const auto& table = getSincTable();
+            const SampleType position = frac * sincPhases;
+            const int phase = juce::jmin(static_cast<int>(position), sincPhases - 1);
+            const SampleType phaseFrac = position - static_cast<SampleType>(phase);
+
+            const SampleType* row0 = table.data() + phase * sincTaps;
+            const SampleType* row1 = row0 + sincTaps;
+
+            // lettura contigua se la finestra non attraversa la fine del ring buffer
+            const int first = idx0 - sincTaps / 2 + 1;
+
+            if (first >= 0 && first + sincTaps <= memorySize)
+                return sincDot(data + first, row0, row1, phaseFrac);
+
+            SampleType wrapped[sincTaps];
+            for (int k = 0; k < sincTaps; ++k)
+                wrapped[k] = at(first + k);
+
+            return sincDot(wrapped, row0, row1, phaseFrac);
+        }
+    }
+
+    static inline SampleType sincDot(const SampleType* taps, const SampleType* row0, const SampleType* row1, SampleType phaseFrac) noexcept
+    {
+        SampleType output = 0;
+        for (int k = 0; k < sincTaps; ++k)
+            output += taps[k] * (row0[k] + phaseFrac * (row1[k] - row0[k]));
+
+        return output;
+    }
+
+    static int getRequiredMemorySize(double rate)
+    {
+        const int maxDelaySamples = static_cast<int>(std::ceil(MAX_DELAY_TIME * rate));
+        return juce::nextPowerOfTwo(maxDelaySamples + INTERPOLATION_GUARD);
+    }
+
+    static constexpr int sincTaps = 8;
+    static constexpr int sincPhases = 256;
+
+    // Tabella polifase: sincPhases + 1 righe di sincTaps coefficienti (finestra di Blackman),
+    // ogni riga normalizzata a guadagno unitario in continua
+    static const std::vector<SampleType>& getSincTable()
+    {
+        static const std::vector<SampleType> table = []
+            {
+                std::vector<SampleType> coefficients(static_cast<size_t>((sincPhases + 1) * sincTaps));
+                constexpr double halfLength = sincTaps / 2;
+
+                for (int phase = 0; phase <= sincPhases; ++phase)
+                {
+                    const double frac = static_cast<double>(phase) / sincPhases;
+                    double sum = 0.0;
+
+                    for (int k = 0; k < sincTaps; ++k)
+                    {
+                        // distanza del tap dal punto letto
+                        const double t = static_cast<double>(k - sincTaps / 2 + 1) - frac;
+                        const double x = juce::MathConstants<double>::pi * t;
+                        const double sinc = std::abs(t) < 1.0e-9 ? 1.0 : std::sin(x) / x;
+                        const double w = 0.42 + 0.5 * std::cos(juce::MathConstants<double>::pi * t / halfLength)
+                                              + 0.08 * std::cos(juce::MathConstants<double>::twoPi * t / halfLength);
+
+                        coefficients[static_cast<size_t>(phase * sincTaps + k)] = static_cast<SampleType>(sinc * w);
+                        sum += sinc * w;
+                    }
+
+                    for (int k = 0; k < sincTaps; ++k)
+                        coefficients[static_cast<size_t>(phase * sincTaps + k)] /= static_cast<SampleType>(sum);
+                }
+
+                return coefficients;
+            }();
+
+        return table;
+    }
+
     double sampleRate = 44100.0;
+    SampleType samplesPerMs = static_cast<SampleType>(44.1);
     int memorySize = 0;
+    int memoryMask = 0;
     int writeIndex = 0;
 
-    float oldSample[2] = { 0.0f, 0.0f };
-    juce::AudioBuffer<float> delayMemory;
+    // Stato per canale, dimensionato in prepareToPlay
+    std::vector<SampleType> thiranState;
+    Interpolation interpolation = Linear;
+
+    // Traiettoria della modulazione a control rate
+    std::vector<SampleType> lastModulationMs, segmentStartMs, segmentStepMs;
+    bool modulationPrimed = false;
+    bool sharedLine = false;
+    int numVoices = 1;
+    juce::AudioBuffer<SampleType> delayMemory;
+
+    BlockSmoothedValue<SampleType> delayTime;
+    BlockSmoothedValue<SampleType> feedback;
 
-    juce::SmoothedValue<double, juce::ValueSmoothingTypes::Linear> delayTime;
-    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> feedback;
+    // Valori del frame corrente nel percorso per-campione (beginSample)
+    SampleType frameDelayMs = static_cast<SampleType>(DEFAULT_DELAY_TIME);
+    SampleType frameFeedback = static_cast<SampleType>(DEFAULT_FEEDBACK);
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Delays)
 };
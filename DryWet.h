@@ -1,66 +1,244 @@
 #pragma once
 #include <JuceHeader.h>
+#include "Smoothing.h"
 
+// SampleType (float/double): buffer, rampe e gain nello stesso tipo del processBlock
+template <typename SampleType>
 class DryWet
 {
 public:
-    DryWet(float defaultDryWetRatio = 0.5f)
+    DryWet(SampleType defaultDryWetRatio = static_cast<SampleType>(0.5), SampleType defaultOutputGainDb = 0)
     {
         dryWetRatio.setCurrentAndTargetValue(defaultDryWetRatio);
+        outputGain.setCurrentAndTargetValue(juce::Decibels::decibelsToGain(defaultOutputGainDb));
     }
 
     ~DryWet() = default;
 
-    // Inizializza buffer e smoothing
-    void prepareToPlay(double sampleRate, int maxNumChannels, int maxNumSamples)
+    // Inizializza buffer e smoothing. maxDryDelay: ritardo massimo del segnale dry
+    // (compensazione della latenza del percorso wet), allocato qui
+    void prepareToPlay(double sampleRate, int maxNumChannels, int maxNumSamples, int maxDryDelay = 0)
     {
         drySignal.setSize(maxNumChannels, maxNumSamples);
         drySignal.clear();
+
+        dryHistory.setSize(maxNumChannels, juce::jmax(1, maxDryDelay));
+        dryHistory.clear();
+        dryDelay = 0;
+
+        wetGains.allocate(static_cast<size_t>(maxNumSamples), true);
+        dryGains.allocate(static_cast<size_t>(maxNumSamples), true);
+
+        dryWetRatio.setMaximumBlockSize(maxNumSamples);
+        outputGain.setMaximumBlockSize(maxNumSamples);
         dryWetRatio.reset(sampleRate, 0.02); // 20 ms di smoothing
+        outputGain.reset(sampleRate, 0.02);
     }
 
     void releaseResources()
     {
         drySignal.setSize(0, 0);
+        dryHistory.setSize(0, 0);
+        dryDelay = 0;
+        wetGains.free();
+        dryGains.free();
+    }
+
+    size_t getMemoryFootprint() const noexcept
+    {
+        // buffer dry + gain wet/dry + rampe dei due parametri + storia per la compensazione di latenza
+        return (static_cast<size_t>(drySignal.getNumChannels() + 4) * static_cast<size_t>(drySignal.getNumSamples())
+              + static_cast<size_t>(dryHistory.getNumChannels()) * static_cast<size_t>(dryHistory.getNumSamples())) * sizeof(SampleType);
     }
 
     // Copia il segnale dry in un buffer interno
-    void copyDrySignal(const juce::AudioBuffer<float>& sourceBuffer)
+    void copyDrySignal(const juce::AudioBuffer<SampleType>& sourceBuffer)
     {
-        jassert(drySignal.getNumChannels() == sourceBuffer.getNumChannels());
+        jassert(drySignal.getNumChannels() >= sourceBuffer.getNumChannels());
         jassert(drySignal.getNumSamples() >= sourceBuffer.getNumSamples());
 
+        const int numSamples = sourceBuffer.getNumSamples();
+
+        for (int ch = 0; ch < sourceBuffer.getNumChannels(); ++ch)
+        {
+            if (dryDelay == 0)
+            {
+                drySignal.copyFrom(ch, 0, sourceBuffer, ch, 0, numSamples);
+                continue;
+            }
+
+            // dry = [storia, ingresso] ritardato di dryDelay; la storia trattiene gli ultimi dryDelay campioni
+            const SampleType* input = sourceBuffer.getReadPointer(ch);
+            SampleType* dry = drySignal.getWritePointer(ch);
+            SampleType* history = dryHistory.getWritePointer(ch);
+
+            if (numSamples >= dryDelay)
+            {
+                juce::FloatVectorOperations::copy(dry, history, dryDelay);
+                juce::FloatVectorOperations::copy(dry + dryDelay, input, numSamples - dryDelay);
+                juce::FloatVectorOperations::copy(history, input + numSamples - dryDelay, dryDelay);
+            }
+            else
+            {
+                juce::FloatVectorOperations::copy(dry, history, numSamples);
+                std::memmove(history, history + numSamples, static_cast<size_t>(dryDelay - numSamples) * sizeof(SampleType));
+                juce::FloatVectorOperations::copy(history + dryDelay - numSamples, input, numSamples);
+            }
+        }
+    }
+
+    // Ritarda il segnale dry di delaySamples (latenza dell'oversampling sul wet), senza allocare
+    void setDryDelay(int delaySamples)
+    {
+        jassert(delaySamples >= 0 && (delaySamples == 0 || delaySamples <= dryHistory.getNumSamples()));
+
+        dryDelay = juce::jlimit(0, dryHistory.getNumSamples(), delaySamples);
+        dryHistory.clear();
+    }
+
+    int getDryDelay() const noexcept { return dryDelay; }
+
+    // Mix fermo a un estremo (nessuna rampa in corso): il processore può saltare
+    // la catena wet (tutto dry) o la copia e il mix del dry (tutto wet)
+    bool isFullyDry() const noexcept { return !dryWetRatio.isSmoothing() && dryWetRatio.getTargetValue() <= 0; }
+    bool isFullyWet() const noexcept { return !dryWetRatio.isSmoothing() && dryWetRatio.getTargetValue() >= 1; }
+
+    // Tutto dry: uscita = dry (ritardato della latenza) * gain, senza buffer wet
+    void processDryOnly(juce::AudioBuffer<SampleType>& buffer)
+    {
+        if (dryDelay > 0)
+        {
+            copyDrySignal(buffer);
+
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                buffer.copyFrom(ch, 0, drySignal, ch, 0, buffer.getNumSamples());
+        }
+
+        applyOutputGain(buffer);
+    }
+
+    // Tutto wet: il dry non serve, si aggiorna solo la storia per la compensazione di latenza
+    // (l'uscita è poi il wet * applyOutputGain)
+    void pushDryHistory(const juce::AudioBuffer<SampleType>& sourceBuffer)
+    {
+        if (dryDelay == 0)
+            return;
+
+        const int numSamples = sourceBuffer.getNumSamples();
+
         for (int ch = 0; ch < sourceBuffer.getNumChannels(); ++ch)
-            drySignal.copyFrom(ch, 0, sourceBuffer, ch, 0, sourceBuffer.getNumSamples());
+        {
+            const SampleType* input = sourceBuffer.getReadPointer(ch);
+            SampleType* history = dryHistory.getWritePointer(ch);
+
+            if (numSamples >= dryDelay)
+            {
+                juce::FloatVectorOperations::copy(history, input + numSamples - dryDelay, dryDelay);
+            }
+            else
+            {
+                std::memmove(history, history + numSamples, static_cast<size_t>(dryDelay - numSamples) * sizeof(SampleType));
+                juce::FloatVectorOperations::copy(history + dryDelay - numSamples, input, numSamples);
+            }
+        }
     }
 
-    // Miscelazione Dry/Wet
-    void mixDrySignal(juce::AudioBuffer<float>& destinationBuffer)
+    // Miscelazione Dry/Wet e gain di uscita in un solo passaggio sul buffer
+    void mixDrySignal(juce::AudioBuffer<SampleType>& destinationBuffer)
     {
         const int numCh = destinationBuffer.getNumChannels();
         const int numSamples = destinationBuffer.getNumSamples();
 
-        for (int smp = 0; smp < numSamples; ++smp)
-        {
-            const float wetGain = dryWetRatio.getNextValue();
-            const float dryGain = 1.0f - wetGain;
+        jassert(drySignal.getNumSamples() >= numSamples);
+
+        const auto wetRatio = dryWetRatio.process(numSamples);
+        const auto gain = outputGain.process(numSamples);
 
+        if (wetRatio.isConstant() && gain.isConstant())
+        {
+            // Fast path: gain costanti per tutto il blocco
             for (int ch = 0; ch < numCh; ++ch)
+                mixConstant(destinationBuffer.getWritePointer(ch), drySignal.getReadPointer(ch),
+                    wetRatio.value * gain.value, (1 - wetRatio.value) * gain.value, numSamples);
+            return;
+        }
+
+        // Gain calcolati una volta per blocco e condivisi da tutti i canali
+        visitSmoothedBlocks(wetRatio, gain, [&](auto wet, auto outGain)
             {
-                auto* dest = destinationBuffer.getWritePointer(ch);
-                const auto* dry = drySignal.getReadPointer(ch);
+                for (int smp = 0; smp < numSamples; ++smp)
+                {
+                    wetGains[smp] = wet[smp] * outGain[smp];
+                    dryGains[smp] = (1 - wet[smp]) * outGain[smp];
+                }
+            });
 
-                dest[smp] = dest[smp] * wetGain + dry[smp] * dryGain;
-            }
+        for (int ch = 0; ch < numCh; ++ch)
+            mixRamp(destinationBuffer.getWritePointer(ch), drySignal.getReadPointer(ch), wetGains, dryGains, numSamples);
+    }
+
+    // Gain wet/dry (già moltiplicati per il gain di uscita) del prossimo campione (percorso fuso)
+    inline void getNextGains(SampleType& wetGain, SampleType& dryGain) noexcept
+    {
+        const SampleType wet = dryWetRatio.getNextValue();
+        const SampleType gain = outputGain.getNextValue();
+
+        wetGain = wet * gain;
+        dryGain = (1 - wet) * gain;
+    }
+
+    // Solo gain di uscita, in rampa se sta cambiando
+    void applyOutputGain(juce::AudioBuffer<SampleType>& buffer)
+    {
+        const int numSamples = buffer.getNumSamples();
+        const auto gain = outputGain.process(numSamples);
+
+        if (gain.isConstant())
+        {
+            buffer.applyGain(gain.value);
         }
+        else
+        {
+            for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+                juce::FloatVectorOperations::multiply(buffer.getWritePointer(ch), gain.ramp, numSamples);
+        }
+    }
+
+    void setDryWetRatio(SampleType newValue)
+    {
+        dryWetRatio.setTargetValue(juce::jlimit(SampleType(0), SampleType(1), newValue));
+    }
+
+    void setOutputGain(SampleType newGainDb)
+    {
+        outputGain.setTargetValue(juce::Decibels::decibelsToGain(newGainDb));
     }
 
-    void setDryWetRatio(float newValue)
+    void snapToTargets() noexcept
     {
-        dryWetRatio.setTargetValue(juce::jlimit(0.0f, 1.0f, newValue));
+        dryWetRatio.snapToTarget();
+        outputGain.snapToTarget();
     }
 
 private:
-    juce::AudioBuffer<float> drySignal;
-    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> dryWetRatio;
+    // Kernel senza dipendenze tra campioni: il compilatore li vettorizza (SSE/AVX/NEON)
+    static void mixRamp(SampleType* dest, const SampleType* dry, const SampleType* wetGain, const SampleType* dryGain, int numSamples) noexcept
+    {
+        for (int smp = 0; smp < numSamples; ++smp)
+            dest[smp] = dest[smp] * wetGain[smp] + dry[smp] * dryGain[smp];
+    }
+
+    static void mixConstant(SampleType* dest, const SampleType* dry, SampleType wetGain, SampleType dryGain, int numSamples) noexcept
+    {
+        for (int smp = 0; smp < numSamples; ++smp)
+            dest[smp] = dest[smp] * wetGain + dry[smp] * dryGain;
+    }
+
+    juce::AudioBuffer<SampleType> drySignal;
+    juce::AudioBuffer<SampleType> dryHistory;
+    int dryDelay = 0;
+    juce::HeapBlock<SampleType> wetGains, dryGains;
+
+    BlockSmoothedValue<SampleType> dryWetRatio;
+    BlockSmoothedValue<SampleType> outputGain;
 };
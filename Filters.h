@@ -1,7 +1,16 @@
 #pragma once
 #include <JuceHeader.h>
 #include "PluginParameters.h"
+#include "Smoothing.h"
 
+// Biquad di più canali in un unico registro SIMD (L/R, 4 o 8 canali per registro)
+#ifndef FILTER_USE_SIMD
+#define FILTER_USE_SIMD JUCE_USE_SIMD
+#endif
+
+// SampleType (float/double): stato, coefficienti e smoothing nello stesso tipo del buffer.
+// In double un registro SIMD contiene metà dei canali
+template <typename SampleType>
 class StereoFilter
 {
 public:
@@ -12,55 +21,173 @@ public:
         BandPass
     };
 
-    StereoFilter(float initialFrequency = Parameters::defaultFilterCutoff,
-        float initialQuality = Parameters::defaultQuality,
+    // Motore del filtro: biquad IIR di JUCE (coefficienti per blocco) o state-variable
+    // TPT (coefficienti calcolati sul posto, cutoff e Q smoothed/modulabili a ogni campione)
+    enum Engine
+    {
+        Biquad = 0,
+        StateVariable
+    };
+
+    StereoFilter(SampleType initialFrequency = Parameters::defaultFilterCutoff,
+        SampleType initialQuality = Parameters::defaultQuality,
         int initialType = Parameters::defaultFilterType)
         : frequency(initialFrequency),
         quality(initialQuality),
         filterType(initialType)
     {
+        smoothedFrequency.setCurrentAndTargetValue(initialFrequency);
+        smoothedQuality.setCurrentAndTargetValue(initialQuality);
+        currentCutoff = initialFrequency;
+        currentQuality = initialQuality;
     }
 
     ~StereoFilter() = default;
 
-    void prepareToPlay(double sr, int numChannels)
+    // Unico punto in cui si alloca lo stato dei filtri
+    void prepareToPlay(double sr, int numChannels, int maxNumSamples)
     {
         sampleRate = sr;
-        iirFilters.clear();
-        iirFilters.resize(numChannels);
-        updateCoefficients(true);
+        smoothedFrequency.setMaximumBlockSize(maxNumSamples);
+        smoothedQuality.setMaximumBlockSize(maxNumSamples);
+        numFilterChannels = numChannels;
+
+        // Stato biquad interlacciato: per ogni gruppo di laneCount canali z1[lanes], z2[lanes]
+        const int numGroups = (numChannels + laneCount - 1) / laneCount;
+        biquadMemory.assign(static_cast<size_t>((numGroups * 2 + 1) * laneCount), SampleType(0));
+#if FILTER_USE_SIMD
+        biquadState = SIMDSample::getNextSIMDAlignedPtr(biquadMemory.data());
+        interleavedMemory.assign(static_cast<size_t>((interleaveChunk + 1) * laneCount), SampleType(0));
+        interleaved = SIMDSample::getNextSIMDAlignedPtr(interleavedMemory.data());
+#else
+        biquadState = biquadMemory.data();
+#endif
+
+        svfChannels.clear();
+        svfChannels.resize(numChannels);
+
+        coefficientsDirty = true;
+        updateCoefficients();
+        resetSmoothing();
         reset();
     }
 
-    void processBlock(juce::AudioBuffer<float>& buffer)
+    void processBlock(juce::AudioBuffer<SampleType>& buffer)
     {
-        juce::dsp::AudioBlock<float> block(buffer);
-        juce::dsp::ProcessContextReplacing<float> context(block);
+        processBlock(buffer, nullptr, 1);
+    }
 
-        for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    // lfoPoints (opzionale): LFO [-1..1] per canale, un punto ogni controlInterval campioni,
+    // sposta il cutoff di modulationDepth ottave. Usato solo dal motore state-variable.
+    void processBlock(juce::AudioBuffer<SampleType>& buffer, const juce::AudioBuffer<SampleType>* lfoPoints, int controlInterval)
+    {
+        if (engine == StateVariable)
         {
-            auto channelBlock = block.getSingleChannelBlock(ch);
-            juce::dsp::ProcessContextReplacing<float> context(channelBlock);
-            iirFilters[ch].process(context);
+            processStateVariable(buffer, lfoPoints, controlInterval);
+            return;
+        }
+
+        updateCoefficients();
+
+        const int numChannels = juce::jmin(buffer.getNumChannels(), numFilterChannels);
+
+#if FILTER_USE_SIMD
+        if (vectorised && numChannels > 1)
+        {
+            processBiquadVectorised(buffer.getArrayOfWritePointers(), numChannels, buffer.getNumSamples());
+            return;
+        }
+#endif
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            SampleType& z1 = biquadZ1(ch);
+            SampleType& z2 = biquadZ2(ch);
+            SampleType* data = buffer.getWritePointer(ch);
+
+            for (int s = 0; s < buffer.getNumSamples(); ++s)
+                data[s] = tickBiquad(data[s], z1, z2);
         }
     }
 
-    void setFrequency(float newFrequency)
+    // Biquad: tutti i canali di un gruppo nello stesso registro (default) o un canale alla volta.
+    // Stessa aritmetica per corsia: l'uscita è identica nei due casi
+    void setVectorised(bool shouldBeVectorised) noexcept { vectorised = shouldBeVectorised; }
+    bool isVectorised() const noexcept { return vectorised; }
+
+    // ====== Percorso per-campione (fuso) ======
+    // Per ogni campione: beginSample(), eventualmente setModulation() per canale, poi
+    // processSample() per canale. Stesso ordine di operazioni del percorso a blocchi.
+    inline void beginSample() noexcept
+    {
+        if (engine == StateVariable && (smoothedFrequency.isSmoothing() || smoothedQuality.isSmoothing()))
+        {
+            currentCutoff = smoothedFrequency.getNextValue();
+            currentQuality = smoothedQuality.getNextValue();
+            markStateVariableDirty();
+        }
+    }
+
+    // Nuovo valore dell'LFO [-1..1] per un canale, tenuto fino al prossimo
+    inline void setModulation(int ch, SampleType lfoValue) noexcept
+    {
+        auto& state = svfChannels[static_cast<size_t>(ch)];
+        state.modulation = modulationDepth * lfoValue;
+        state.dirty = true;
+    }
+
+    // Un campione di un canale
+    inline SampleType processSample(int ch, SampleType input) noexcept
+    {
+        if (engine == StateVariable)
+        {
+            auto& state = svfChannels[static_cast<size_t>(ch)];
+
+            if (state.dirty)
+                computeStateVariable(state);
+
+            switch (filterType)
+            {
+            case HighPass: return tickStateVariable<HighPass>(state, input);
+            case BandPass: return tickStateVariable<BandPass>(state, input);
+            default:       return tickStateVariable<LowPass>(state, input);
+            }
+        }
+
+        return tickBiquad(input, biquadZ1(ch), biquadZ2(ch));
+    }
+
+    // I setter non toccano i coefficienti: li marcano da ricalcolare, updateCoefficients()
+    // li aggiorna sul posto (senza allocare) dal thread audio, una volta per blocco
+    void setSampleRate(double sr)
+    {
+        sampleRate = sr;
+        coefficientsDirty = true;
+        updateCoefficients();
+        resetSmoothing();
+        reset();
+    }
+
+    void setFrequency(SampleType newFrequency)
     {
         if (!juce::approximatelyEqual(frequency, newFrequency))
         {
             frequency = newFrequency;
-            updateCoefficients();
+            coefficientsDirty = true;
         }
+
+        smoothedFrequency.setTargetValue(newFrequency);
     }
 
-    void setQuality(float newQuality)
+    void setQuality(SampleType newQuality)
     {
         if (!juce::approximatelyEqual(quality, newQuality))
         {
             quality = newQuality;
-            updateCoefficients();
+            coefficientsDirty = true;
         }
+
+        smoothedQuality.setTargetValue(newQuality);
     }
 
     void setFilterType(int newType)
@@ -68,46 +195,371 @@ public:
         if (filterType != newType)
         {
             filterType = newType;
-            updateCoefficients();
+            coefficientsDirty = true;
+            markStateVariableDirty();
         }
     }
 
-    void reset()
+    void setEngine(int newEngine)
     {
-        for (auto& f : iirFilters)
-            f.reset();
+        jassert(newEngine == Biquad || newEngine == StateVariable);
+
+        if (engine != newEngine)
+        {
+            engine = newEngine;
+            reset();
+
+            // Il biquad usa cutoff e Q senza smoothing e non lo fa avanzare: il motore nuovo parte dai target
+            snapToTargets();
+        }
     }
 
-private:
-    void updateCoefficients(bool forceUpdate = false)
+    int getEngine() const noexcept { return engine; }
+
+    // Escursione del cutoff pilotata dall'LFO, in ottave
+    void setModulationDepth(SampleType newDepth)
+    {
+        if (!juce::approximatelyEqual(modulationDepth, newDepth))
+        {
+            modulationDepth = newDepth;
+
+            for (auto& state : svfChannels)
+                state.modulation = 0;
+
+            markStateVariableDirty();
+        }
+    }
+
+    // Cutoff e Q saltano al target
+    void snapToTargets() noexcept
+    {
+        smoothedFrequency.snapToTarget();
+        smoothedQuality.snapToTarget();
+        currentCutoff = smoothedFrequency.getCurrentValue();
+        currentQuality = smoothedQuality.getCurrentValue();
+        markStateVariableDirty();
+    }
+
+    // Avanza lo smoothing di cutoff e Q senza elaborare
+    void skip(int numSamples) noexcept
+    {
+        currentCutoff = smoothedFrequency.skip(numSamples);
+        currentQuality = smoothedQuality.skip(numSamples);
+        markStateVariableDirty();
+    }
+
+    // true se il cutoff segue l'LFO (serve il buffer dell'LFO)
+    bool isModulated() const noexcept { return engine == StateVariable && modulationDepth > 0; }
+
+    // Ricalcola i coefficienti condivisi dai canali se un parametro è cambiato
+    void updateCoefficients() noexcept
+    {
+        if (!coefficientsDirty)
+            return;
+
+        biquad = makeBiquad(sampleRate, frequency, quality, filterType);
+        coefficientsDirty = false;
+    }
+
+    // Coefficienti b0 b1 b2 a1 a2 (normalizzati per a0, come IIR::Coefficients)
+    static std::array<SampleType, 5> makeBiquad(double sr, SampleType cutoff, SampleType q, int type) noexcept
     {
-        using Coeff = juce::dsp::IIR::Coefficients<float>;
-        typename Coeff::Ptr coeffs = nullptr;
+        using ArrayCoeff = juce::dsp::IIR::ArrayCoefficients<SampleType>;
+        std::array<SampleType, 6> c;
 
-        switch (filterType)
+        switch (type)
         {
-        case LowPass:  coeffs = Coeff::makeLowPass(sampleRate, frequency, quality); break;
-        case HighPass: coeffs = Coeff::makeHighPass(sampleRate, frequency, quality); break;
-        case BandPass: coeffs = Coeff::makeBandPass(sampleRate, frequency, quality); break;
+        case LowPass:  c = ArrayCoeff::makeLowPass(sr, cutoff, q); break;
+        case HighPass: c = ArrayCoeff::makeHighPass(sr, cutoff, q); break;
+        case BandPass: c = ArrayCoeff::makeBandPass(sr, cutoff, q); break;
         default:
             jassertfalse;
-            coeffs = Coeff::makeLowPass(sampleRate, frequency, quality);
+            c = ArrayCoeff::makeLowPass(sr, cutoff, q);
             break;
         }
 
-        if (coeffs != nullptr || forceUpdate)
+        const SampleType a0inv = juce::approximatelyEqual(c[3], SampleType(0)) ? SampleType(1) : 1 / c[3];
+        return { c[0] * a0inv, c[1] * a0inv, c[2] * a0inv, c[4] * a0inv, c[5] * a0inv };
+    }
+
+    // Risposta in ampiezza (guadagno lineare) alle frequenze date, dagli stessi coefficienti del biquad.
+    // Vale anche per il motore state-variable: stesso prototipo analogico e stessa bilineare con
+    // prewarping, quindi la stessa curva (a parte la modulazione del cutoff da parte dell'LFO)
+    static void getMagnitudeResponse(double sr, SampleType cutoff, SampleType q, int type,
+        const double* frequencies, double* magnitudes, int numFrequencies) noexcept
+    {
+        const auto c = makeBiquad(sr, cutoff, q, type);
+
+        for (int i = 0; i < numFrequencies; ++i)
+        {
+            // H(z) con z^-1 = e^-jw
+            const double w = juce::MathConstants<double>::twoPi * frequencies[i] / sr;
+            const std::complex<double> z1 = std::polar(1.0, -w), z2 = z1 * z1;
+            const auto numerator = static_cast<double>(c[0]) + static_cast<double>(c[1]) * z1 + static_cast<double>(c[2]) * z2;
+            const auto denominator = 1.0 + static_cast<double>(c[3]) * z1 + static_cast<double>(c[4]) * z2;
+            magnitudes[i] = std::abs(numerator / denominator);
+        }
+    }
+
+    void reset()
+    {
+        std::fill(biquadMemory.begin(), biquadMemory.end(), SampleType(0));
+
+        for (auto& state : svfChannels)
         {
-            for (auto& f : iirFilters)
-                f.coefficients = coeffs;
+            state.ic1eq = state.ic2eq = 0;
+            state.dirty = true;
         }
     }
 
-    float frequency = 0.0f;
-    float quality = 0.0f;
+    // Massima differenza tra lo stato di due canali (motore attivo)
+    SampleType getChannelDifference(int a, int b) noexcept
+    {
+        if (engine == StateVariable)
+        {
+            const auto& x = svfChannels[static_cast<size_t>(a)];
+            const auto& y = svfChannels[static_cast<size_t>(b)];
+            return juce::jmax(std::abs(x.ic1eq - y.ic1eq), std::abs(x.ic2eq - y.ic2eq));
+        }
+
+        return juce::jmax(std::abs(biquadZ1(a) - biquadZ1(b)), std::abs(biquadZ2(a) - biquadZ2(b)));
+    }
+
+    // Il canale destination riprende lo stato (e la modulazione) di source
+    void copyChannelState(int source, int destination) noexcept
+    {
+        biquadZ1(destination) = biquadZ1(source);
+        biquadZ2(destination) = biquadZ2(source);
+        svfChannels[static_cast<size_t>(destination)] = svfChannels[static_cast<size_t>(source)];
+    }
+
+private:
+    // ====== Biquad (trasposta diretta II, stesso ordine di operazioni di IIR::Filter) ======
+#if FILTER_USE_SIMD
+    using SIMDSample = juce::dsp::SIMDRegister<SampleType>;
+    static constexpr int laneCount = static_cast<int>(SIMDSample::SIMDNumElements);
+    static constexpr int interleaveChunk = 64;
+#else
+    static constexpr int laneCount = 1;
+#endif
+
+    inline SampleType& biquadZ1(int ch) noexcept { return biquadState[(ch / laneCount) * 2 * laneCount + ch % laneCount]; }
+    inline SampleType& biquadZ2(int ch) noexcept { return biquadState[(ch / laneCount) * 2 * laneCount + laneCount + ch % laneCount]; }
+
+    inline SampleType tickBiquad(SampleType x, SampleType& z1, SampleType& z2) const noexcept
+    {
+        const SampleType y = biquad[0] * x + z1;
+        z1 = biquad[1] * x - biquad[3] * y + z2;
+        z2 = biquad[2] * x - biquad[4] * y;
+        return y;
+    }
+
+#if FILTER_USE_SIMD
+    // Il blocco viene interlacciato a tratti di interleaveChunk campioni in un buffer allineato:
+    // la ricorsione legge e scrive solo registri interi, lo stato resta nei registri
+    void processBiquadVectorised(SampleType* const* channelData, int numChannels, int numSamples) noexcept
+    {
+        const auto b0 = SIMDSample::expand(biquad[0]);
+        const auto b1 = SIMDSample::expand(biquad[1]);
+        const auto b2 = SIMDSample::expand(biquad[2]);
+        const auto a1 = SIMDSample::expand(biquad[3]);
+        const auto a2 = SIMDSample::expand(biquad[4]);
+
+        for (int first = 0; first < numChannels; first += laneCount)
+        {
+            const int lanes = juce::jmin(laneCount, numChannels - first);
+            SampleType* state = biquadState + first * 2;
+
+            auto z1 = SIMDSample::fromRawArray(state);
+            auto z2 = SIMDSample::fromRawArray(state + laneCount);
+
+            // Le corsie senza canale elaborano zeri
+            if (lanes < laneCount)
+                std::fill(interleaved, interleaved + interleaveChunk * laneCount, SampleType(0));
+
+            for (int start = 0; start < numSamples; start += interleaveChunk)
+            {
+                const int length = juce::jmin(interleaveChunk, numSamples - start);
+
+                for (int lane = 0; lane < lanes; ++lane)
+                {
+                    const SampleType* source = channelData[first + lane] + start;
+                    for (int s = 0; s < length; ++s)
+                        interleaved[s * laneCount + lane] = source[s];
+                }
+
+                for (int s = 0; s < length; ++s)
+                {
+                    SampleType* frame = interleaved + s * laneCount;
+
+                    const auto x = SIMDSample::fromRawArray(frame);
+                    const auto y = b0 * x + z1;
+                    z1 = b1 * x - a1 * y + z2;
+                    z2 = b2 * x - a2 * y;
+
+                    y.copyToRawArray(frame);
+                }
+
+                for (int lane = 0; lane < lanes; ++lane)
+                {
+                    SampleType* destination = channelData[first + lane] + start;
+                    for (int s = 0; s < length; ++s)
+                        destination[s] = interleaved[s * laneCount + lane];
+                }
+            }
+
+            z1.copyToRawArray(state);
+            z2.copyToRawArray(state + laneCount);
+        }
+    }
+#endif
+
+    // ====== State-variable TPT (Zavalishin / Simper) ======
+    struct StateVariableChannel
+    {
+        SampleType ic1eq = 0, ic2eq = 0;        // stato degli integratori trapezoidali
+        SampleType k = 1, a1 = 1, a2 = 0, a3 = 0;
+        SampleType modulation = 0;              // ottave
+        bool dirty = true;
+    };
+
+    void resetSmoothing()
+    {
+        smoothedFrequency.reset(sampleRate, 0.02);
+        smoothedQuality.reset(sampleRate, 0.02);
+        smoothedFrequency.setCurrentAndTargetValue(frequency);
+        smoothedQuality.setCurrentAndTargetValue(quality);
+        currentCutoff = frequency;
+        currentQuality = quality;
+        markStateVariableDirty();
+    }
+
+    inline void markStateVariableDirty() noexcept
+    {
+        for (auto& state : svfChannels)
+            state.dirty = true;
+    }
+
+    // g = tan(pi*fc/fs), k = 1/Q; nessuna allocazione
+    inline void computeStateVariable(StateVariableChannel& state) noexcept
+    {
+        SampleType cutoff = currentCutoff;
+
+        if (state.modulation != 0)
+            cutoff *= std::exp2(state.modulation);
+
+        const SampleType nyquistLimit = static_cast<SampleType>(0.49 * sampleRate);
+        cutoff = juce::jlimit(SampleType(10), nyquistLimit, cutoff);
+
+        const SampleType g = std::tan(juce::MathConstants<SampleType>::pi * cutoff / static_cast<SampleType>(sampleRate));
+
+        state.k = 1 / currentQuality;
+        state.a1 = 1 / (1 + g * (g + state.k));
+        state.a2 = g * state.a1;
+        state.a3 = g * state.a2;
+        state.dirty = false;
+    }
+
+    template <int Type>
+    static inline SampleType tickStateVariable(StateVariableChannel& state, SampleType v0) noexcept
+    {
+        const SampleType v3 = v0 - state.ic2eq;
+        const SampleType v1 = state.a1 * state.ic1eq + state.a2 * v3;
+        const SampleType v2 = state.ic2eq + state.a2 * state.ic1eq + state.a3 * v3;
+
+        state.ic1eq = 2 * v1 - state.ic1eq;
+        state.ic2eq = 2 * v2 - state.ic2eq;
+
+        if constexpr (Type == HighPass)
+            return v0 - state.k * v1 - v2;
+        else if constexpr (Type == BandPass)
+            return state.k * v1;                        // guadagno unitario al centro, come il biquad
+        else
+            return v2;
+    }
+
+    template <int Type>
+    static void processStateVariableChannel(StateVariableChannel& state, SampleType* data, int numSamples) noexcept
+    {
+        for (int s = 0; s < numSamples; ++s)
+            data[s] = tickStateVariable<Type>(state, data[s]);
+    }
+
+    void processStateVariable(juce::AudioBuffer<SampleType>& buffer, const juce::AudioBuffer<SampleType>* lfoPoints, int controlInterval)
+    {
+        const int numChannels = juce::jmin(buffer.getNumChannels(), static_cast<int>(svfChannels.size()));
+        const int numSamples = buffer.getNumSamples();
+        auto channelData = buffer.getArrayOfWritePointers();
+
+        const bool modulated = lfoPoints != nullptr && isModulated();
+        const bool smoothing = smoothedFrequency.isSmoothing() || smoothedQuality.isSmoothing();
+
+        if (!modulated && !smoothing)
+        {
+            // Coefficienti costanti nel blocco: loop stretto per canale
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& state = svfChannels[static_cast<size_t>(ch)];
+
+                if (state.dirty)
+                    computeStateVariable(state);
+
+                switch (filterType)
+                {
+                case HighPass: processStateVariableChannel<HighPass>(state, channelData[ch], numSamples); break;
+                case BandPass: processStateVariableChannel<BandPass>(state, channelData[ch], numSamples); break;
+                default:       processStateVariableChannel<LowPass>(state, channelData[ch], numSamples); break;
+                }
+            }
+            return;
+        }
+
+        // Cutoff/Q in rampa o modulati: coefficienti aggiornati campione per campione,
+        // rampe dello smoothing calcolate una volta per il blocco
+        const auto cutoffBlock = smoothedFrequency.process(numSamples);
+        const auto qualityBlock = smoothedQuality.process(numSamples);
+
+        visitSmoothedBlocks(cutoffBlock, qualityBlock, [&](auto cutoffHz, auto qualityValue)
+            {
+                for (int s = 0; s < numSamples; ++s)
+                {
+                    if (smoothing)
+                    {
+                        currentCutoff = cutoffHz[s];
+                        currentQuality = qualityValue[s];
+                        markStateVariableDirty();
+                    }
+
+                    if (modulated && s % controlInterval == 0)
+                        for (int ch = 0; ch < numChannels; ++ch)
+                            setModulation(ch, lfoPoints->getSample(juce::jmin(ch, lfoPoints->getNumChannels() - 1), s / controlInterval));
+
+                    for (int ch = 0; ch < numChannels; ++ch)
+                        channelData[ch][s] = processSample(ch, channelData[ch][s]);
+                }
+            });
+    }
+
+    SampleType frequency = 0;
+    SampleType quality = 0;
     int filterType = 0;
     double sampleRate = 44100.0;
 
-    std::vector<juce::dsp::IIR::Filter<float>> iirFilters;
+    std::array<SampleType, 5> biquad{ 1, 0, 0, 0, 0 };   // b0 b1 b2 a1 a2
+    std::vector<SampleType> biquadMemory;
+    SampleType* biquadState = nullptr;
+    std::vector<SampleType> interleavedMemory;   // campioni interlacciati per il percorso SIMD
+    SampleType* interleaved = nullptr;
+    int numFilterChannels = 0;
+    bool vectorised = true;
+    bool coefficientsDirty = true;
+
+    int engine = Biquad;
+    SampleType modulationDepth = 0;
+    std::vector<StateVariableChannel> svfChannels;
+    BlockSmoothedValue<SampleType, juce::ValueSmoothingTypes::Multiplicative> smoothedFrequency;
+    BlockSmoothedValue<SampleType> smoothedQuality;
+    SampleType currentCutoff = 0, currentQuality = 1;   // valori dello smoothing al campione corrente
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StereoFilter)
 };
@@ -0,0 +1,237 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Misura del carico DSP in processBlock (tempo per stadio rispetto alla durata del blocco).
+// Attiva di default solo in debug; i tool la abilitano con FLANGER_DSP_PROFILING=1 su tutto il target.
+// Con FLANGER_DSP_PROFILING=0 la classe e tutte le chiamate spariscono dalla build
+#ifndef FLANGER_DSP_PROFILING
+#if JUCE_DEBUG
+#define FLANGER_DSP_PROFILING 1
+#else
+#define FLANGER_DSP_PROFILING 0
+#endif
+#endif
+
+#if FLANGER_DSP_PROFILING
+
+//==============================================================
+//                       DspLoadMeter
+//==============================================================
+// Thread audio: beginBlock(), endStage() alla fine di ogni stadio, endBlock().
+// Le statistiche sono pubblicate in atomic scritti solo dal thread audio: l'editor
+// (o un tool) le legge con getSnapshot() senza lock. resetStatistics() chiede
+// l'azzeramento, eseguito dal thread audio al blocco successivo.
+class DspLoadMeter
+{
+public:
+    // Control: parametri, rilevamento del silenzio e tutto ciò che non è in uno stadio
+    enum Stage { Control = 0, DryCopy, Modulation, Delay, Filter, Mix, Oversampling, Fused, numStages };
+
+    // Istogramma del carico per blocco: limiti superiori delle classi (l'ultima raccoglie gli overrun)
+    static constexpr int numHistogramBins = 9;
+    static constexpr std::array<double, numHistogramBins - 1> histogramEdges{ 0.005, 0.01, 0.02, 0.05, 0.1, 0.2, 0.5, 1.0 };
+
+    struct Snapshot
+    {
+        double lastLoad = 0, minLoad = 0, averageLoad = 0, maxLoad = 0;    // frazione della durata del blocco
+        std::array<double, numStages> stageLoad{};                          // carico medio per stadio
+        std::array<juce::uint32, numHistogramBins> histogram{};
+        juce::uint64 numBlocks = 0;
+    };
+
+    DspLoadMeter()
+    {
+        static_assert(std::atomic<double>::is_always_lock_free, "DspLoadMeter richiede atomic<double> lock-free");
+    }
+
+    void prepare(double newSampleRate) noexcept
+    {
+        sampleRate = newSampleRate;
+        resetRequested.store(true);
+    }
+
+    void resetStatistics() noexcept { resetRequested.store(true); }
+
+    static const char* getStageName(int stage) noexcept
+    {
+        static const char* const names[numStages] = { "control", "dry", "modulation", "delay", "filter", "mix", "oversampling", "fused" };
+        return juce::isPositiveAndBelow(stage, static_cast<int>(numStages)) ? names[stage] : "";
+    }
+
+    // ====== Thread audio ======
+    inline void beginBlock(int numSamples) noexcept
+    {
+        blockSamples = numSamples;
+        blockStart = stageStart = juce::Time::getHighResolutionTicks();
+    }
+
+    inline void endStage(Stage stage) noexcept
+    {
+        const auto now = juce::Time::getHighResolutionTicks();
+        blockTicks[stage] += now - stageStart;
+        stageStart = now;
+    }
+
+    void endBlock() noexcept
+    {
+        endStage(Control);
+
+        if (resetRequested.exchange(false))
+            clearStatistics();
+
+        const double deadline = static_cast<double>(blockSamples) / sampleRate;
+        if (deadline <= 0)
+        {
+            std::fill(std::begin(blockTicks), std::end(blockTicks), 0);
+            return;
+        }
+
+        const double secondsPerTick = 1.0 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond());
+        const double load = static_cast<double>(stageStart - blockStart) * secondsPerTick / deadline;
+
+        // Somme locali (solo thread audio), poi pubblicazione
+        ++numBlocks;
+        totalDeadline += deadline;
+        totalLoadSeconds += load * deadline;
+        minLoad = numBlocks == 1 ? load : juce::jmin(minLoad, load);
+        maxLoad = juce::jmax(maxLoad, load);
+
+        for (int s = 0; s < numStages; ++s)
+        {
+            stageSeconds[(size_t)s] += static_cast<double>(blockTicks[s]) * secondsPerTick;
+            blockTicks[s] = 0;
+            publishedStageLoad[(size_t)s].store(stageSeconds[(size_t)s] / totalDeadline, std::memory_order_relaxed);
+        }
+
+        const auto bin = std::upper_bound(histogramEdges.begin(), histogramEdges.end(), load) - histogramEdges.begin();
+        publishedHistogram[(size_t)bin].store(publishedHistogram[(size_t)bin].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+        publishedLastLoad.store(load, std::memory_order_relaxed);
+        publishedMinLoad.store(minLoad, std::memory_order_relaxed);
+        publishedMaxLoad.store(maxLoad, std::memory_order_relaxed);
+        publishedAverageLoad.store(totalLoadSeconds / totalDeadline, std::memory_order_relaxed);
+        publishedNumBlocks.store(numBlocks, std::memory_order_release);
+    }
+
+    // ====== Editor / tool ======
+    // I campi sono letti uno alla volta: possono appartenere a blocchi consecutivi
+    Snapshot getSnapshot() const noexcept
+    {
+        Snapshot snapshot;
+        snapshot.numBlocks = publishedNumBlocks.load(std::memory_order_acquire);
+        snapshot.lastLoad = publishedLastLoad.load(std::memory_order_relaxed);
+        snapshot.minLoad = publishedMinLoad.load(std::memory_order_relaxed);
+        snapshot.averageLoad = publishedAverageLoad.load(std::memory_order_relaxed);
+        snapshot.maxLoad = publishedMaxLoad.load(std::memory_order_relaxed);
+
+        for (size_t s = 0; s < numStages; ++s)
+            snapshot.stageLoad[s] = publishedStageLoad[s].load(std::memory_order_relaxed);
+
+        for (size_t b = 0; b < numHistogramBins; ++b)
+            snapshot.histogram[b] = publishedHistogram[b].load(std::memory_order_relaxed);
+
+        return snapshot;
+    }
+
+private:
+    void clearStatistics() noexcept
+    {
+        numBlocks = 0;
+        totalDeadline = totalLoadSeconds = 0;
+        minLoad = maxLoad = 0;
+        stageSeconds.fill(0);
+
+        for (auto& stage : publishedStageLoad) stage.store(0, std::memory_order_relaxed);
+        for (auto& bin : publishedHistogram) bin.store(0, std::memory_order_relaxed);
+    }
+
+    double sampleRate = 44100.0;
+
+    // Stato del thread audio
+    int blockSamples = 0;
+    juce::int64 blockStart = 0, stageStart = 0;
+    juce::int64 blockTicks[numStages] = {};
+    std::array<double, numStages> stageSeconds{};
+    juce::uint64 numBlocks = 0;
+    double totalDeadline = 0, totalLoadSeconds = 0, minLoad = 0, maxLoad = 0;
+
+    // Pubblicati per i lettori
+    std::atomic<double> publishedLastLoad{ 0 }, publishedMinLoad{ 0 }, publishedAverageLoad{ 0 }, publishedMaxLoad{ 0 };
+    std::array<std::atomic<double>, numStages> publishedStageLoad{};
+    std::array<std::atomic<juce::uint32>, numHistogramBins> publishedHistogram{};
+    std::atomic<juce::uint64> publishedNumBlocks{ 0 };
+    std::atomic<bool> resetRequested{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DspLoadMeter)
+};
+
+//==============================================================
+//                       EditorFrameTimer
+//==============================================================
+// Tempo di disegno dell'editor, solo thread dei messaggi: begin() in paint(), end() in
+// paintOverChildren(), così ogni passaggio copre l'editor e tutti i figli ridisegnati.
+// collect() restituisce le statistiche dall'ultima chiamata e le azzera.
+class EditorFrameTimer
+{
+public:
+    struct Stats
+    {
+        double averageMs = 0, maxMs = 0;    // tempo per passaggio di disegno
+        double framesPerSecond = 0;
+    };
+
+    void begin() noexcept { frameStart = juce::Time::getHighResolutionTicks(); }
+
+    void end() noexcept
+    {
+        // paint() può essere saltato se i figli opachi coprono tutta la regione
+        if (frameStart == 0)
+            return;
+
+        const double ms = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - frameStart) * 1000.0;
+        totalMs += ms;
+        maxMs = juce::jmax(maxMs, ms);
+        ++numFrames;
+        frameStart = 0;
+    }
+
+    Stats collect() noexcept
+    {
+        const auto now = juce::Time::getHighResolutionTicks();
+        const double elapsed = windowStart > 0 ? juce::Time::highResolutionTicksToSeconds(now - windowStart) : 0.0;
+
+        Stats stats;
+        if (numFrames > 0)
+        {
+            stats.averageMs = totalMs / numFrames;
+            stats.maxMs = maxMs;
+        }
+        if (elapsed > 0)
+            stats.framesPerSecond = numFrames / elapsed;
+
+        windowStart = now;
+        totalMs = maxMs = 0;
+        numFrames = 0;
+        return stats;
+    }
+
+private:
+    juce::int64 frameStart = 0, windowStart = 0;
+    double totalMs = 0, maxMs = 0;
+    int numFrames = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EditorFrameTimer)
+};
+
+// Marcatori usati in processBlock: vuoti se la misura è disabilitata
+#define FLANGER_LOAD_BEGIN(meter, numSamples) (meter).beginBlock(numSamples)
+#define FLANGER_LOAD_STAGE(meter, stage) (meter).endStage(DspLoadMeter::stage)
+#define FLANGER_LOAD_END(meter) (meter).endBlock()
+
+#else
+
+#define FLANGER_LOAD_BEGIN(meter, numSamples)
+#define FLANGER_LOAD_STAGE(meter, stage)
+#define FLANGER_LOAD_END(meter)
+
+#endif
@@ -1,35 +1,53 @@
 #pragma once
 #include <JuceHeader.h>
+#include "Smoothing.h"
+
+// Modalità multi-voce: la voce v di N ha profondità 1 - VOICE_DEPTH_SPREAD * v / N
+#ifndef VOICE_DEPTH_SPREAD
+#define VOICE_DEPTH_SPREAD 0.5
+#endif
 
 //==============================================================
 //                       NaiveOscillator
 //==============================================================
+// Fase intera a 32 bit: un giro completo = 2^32, il wrap è l'overflow naturale
+// dell'unsigned (esatto e senza branch). Le forme d'onda sono kernel a blocchi
+// specializzati per waveform: lo switch viene fatto una volta per blocco.
+// SampleType (float/double): tipo dell'uscita e di tutta l'aritmetica per campione.
+template <typename SampleType>
 class NaiveOscillator
 {
 public:
     enum Waveform { Sine = 0, Triangle, SawUp, SawDown, Square };
 
-    NaiveOscillator(double defaultFrequency = 440.0, Waveform defaultWaveform = Sine)
+    NaiveOscillator(SampleType defaultFrequency = 440, Waveform defaultWaveform = Sine)
         : waveform(defaultWaveform)
     {
         frequency.setCurrentAndTargetValue(defaultFrequency);
     }
 
-    void prepareToPlay(double sampleRate)
+    void prepareToPlay(double sampleRate, int maxNumSamples)
+    {
+        frequency.setMaximumBlockSize(maxNumSamples);
+        setSampleRate(sampleRate);
+    }
+
+    // Cambia sample rate (fattore di oversampling) senza allocare
+    void setSampleRate(double sampleRate)
     {
         jassert(sampleRate > 0.0);
-        samplingPeriod = 1.0 / sampleRate;
+        phaseScale = static_cast<SampleType>(4294967296.0 / sampleRate);
         frequency.reset(sampleRate, 0.02); // 20 ms smoothing
     }
 
     void reset(double startPhase = 0.0)
     {
-        currentPhase = wrap01(startPhase);
+        currentPhase = cyclesToPhase(startPhase);
     }
 
-    void setFrequency(double newValue)
+    void setFrequency(SampleType newValue)
     {
-        jassert(newValue > 0.0);
+        jassert(newValue > 0);
         frequency.setTargetValue(newValue);
     }
 
@@ -38,45 +56,164 @@ public:
         waveform = newWaveform;
     }
 
-    double getCurrentPhase() const noexcept { return currentPhase; }
+    void snapToTargets() noexcept { frequency.snapToTarget(); }
+
+    double getCurrentPhase() const noexcept { return currentPhase * (1.0 / 4294967296.0); }
+
+    // Converte una fase in cicli (anche fuori da [0,1)) nella fase intera
+    static inline juce::uint32 cyclesToPhase(double cycles) noexcept
+    {
+        return static_cast<juce::uint32>(static_cast<juce::int64>(std::floor(cycles * 4294967296.0 + 0.5)));
+    }
 
     inline void advancePhase() noexcept
     {
-        const double phaseIncrement = frequency.getNextValue() * samplingPeriod;
-        currentPhase = wrap01(currentPhase + phaseIncrement);
+        currentPhase += getPhaseIncrement(frequency.getNextValue());
     }
 
-    inline double generateSample(double phase) const noexcept
+    // Avanza di più campioni in una volta (control rate)
+    inline void advancePhase(int numSamples) noexcept
+    {
+        if (frequency.isSmoothing())
+        {
+            for (int s = 0; s < numSamples; ++s)
+                advancePhase();
+        }
+        else
+        {
+            currentPhase += static_cast<juce::uint32>(numSamples) * getPhaseIncrement(frequency.getTargetValue());
+        }
+    }
+
+    // Un campione dell'LFO [-1..1] alla fase data (percorso per-campione)
+    inline SampleType generateSample(juce::uint32 phase) const noexcept
     {
         switch (waveform)
         {
-        case Sine:
-            return std::sin(phase * juce::MathConstants<double>::twoPi);
-        case Triangle:
-            return 2.0 * std::abs(2.0 * phase - 1.0) - 1.0; // [-1,1]
-        case SawUp:
-            return (2.0 * phase) - 1.0; // [-1,1]
-        case SawDown:
-            return 1.0 - (2.0 * phase); // [-1,1]
-        case Square:
-            return (phase < 0.5) ? 1.0 : -1.0;
+        case Sine:     return shape<Sine>(phase);
+        case Triangle: return shape<Triangle>(phase);
+        case SawUp:    return shape<SawUp>(phase);
+        case SawDown:  return shape<SawDown>(phase);
+        case Square:   return shape<Square>(phase);
         default:
             jassertfalse;
-            return 0.0;
+            return 0;
+        }
+    }
+
+    inline SampleType generateSample() const noexcept { return generateSample(currentPhase); }
+    inline juce::uint32 getPhase() const noexcept { return currentPhase; }
+
+    // Riempie un blocco di LFO [-1..1] per numOutputs uscite e avanza la fase:
+    // l'uscita k è sfasata di k * phaseSpacing rispetto alla fase corrente
+    void renderBlock(SampleType* const* outputs, int numOutputs, juce::uint32 phaseSpacing, int numSamples) noexcept
+    {
+        renderBlockAt(outputs, numOutputs, [phaseSpacing](int k) { return static_cast<juce::uint32>(k) * phaseSpacing; }, numSamples);
+    }
+
+    // Come sopra, con lo sfasamento dell'uscita k dato da phaseOffset(k) (voci della modalità multi-voce)
+    template <typename PhaseOffset>
+    void renderBlockAt(SampleType* const* outputs, int numOutputs, PhaseOffset phaseOffset, int numSamples) noexcept
+    {
+        switch (waveform)
+        {
+        case Sine:     renderWaveform<Sine>(outputs, numOutputs, phaseOffset, numSamples); break;
+        case Triangle: renderWaveform<Triangle>(outputs, numOutputs, phaseOffset, numSamples); break;
+        case SawUp:    renderWaveform<SawUp>(outputs, numOutputs, phaseOffset, numSamples); break;
+        case SawDown:  renderWaveform<SawDown>(outputs, numOutputs, phaseOffset, numSamples); break;
+        case Square:   renderWaveform<Square>(outputs, numOutputs, phaseOffset, numSamples); break;
+        default:       jassertfalse; break;
         }
     }
 
+    // mainOut alla fase corrente, offsetOut (se non nullo) sfasato di phaseOffset
+    void renderBlock(SampleType* mainOut, SampleType* offsetOut, juce::uint32 phaseOffset, int numSamples) noexcept
+    {
+        SampleType* outputs[] = { mainOut, offsetOut };
+        renderBlock(outputs, offsetOut != nullptr ? 2 : 1, phaseOffset, numSamples);
+    }
+
 private:
-    static inline double wrap01(double x) noexcept
+    template <Waveform W, typename PhaseOffset>
+    void renderWaveform(SampleType* const* outputs, int numOutputs, PhaseOffset phaseOffset, int numSamples) noexcept
+    {
+        const auto hz = frequency.process(numSamples);
+
+        if (!hz.isConstant())
+        {
+            // Frequenza in rampa: incremento diverso a ogni campione
+            for (int s = 0; s < numSamples; ++s)
+            {
+                for (int k = 0; k < numOutputs; ++k)
+                    outputs[k][s] = shape<W>(currentPhase + phaseOffset(k));
+
+                currentPhase += getPhaseIncrement(hz.ramp[s]);
+            }
+            return;
+        }
+
+        // Frequenza costante: fase(s) = fase0 + s * incremento, nessuna dipendenza tra campioni.
+        // Un passaggio per uscita, vettorizzato sui campioni
+        const juce::uint32 start = currentPhase;
+        const juce::uint32 increment = getPhaseIncrement(hz.value);
+
+        for (int k = 0; k < numOutputs; ++k)
+        {
+            SampleType* out = outputs[k];
+            const juce::uint32 first = start + phaseOffset(k);
+
+            for (int s = 0; s < numSamples; ++s)
+                out[s] = shape<W>(first + static_cast<juce::uint32>(s) * increment);
+        }
+
+        currentPhase = start + static_cast<juce::uint32>(numSamples) * increment;
+    }
+
+    // Forme d'onda sulla fase intera, senza branch (solo select)
+    template <Waveform W>
+    static inline SampleType shape(juce::uint32 phase) noexcept
+    {
+        constexpr auto scale = static_cast<SampleType>(1.0 / 2147483648.0);
+
+        // fase con segno in [-1,1): x = 2*phi per phi < 0.5, 2*phi - 2 altrimenti
+        const SampleType x = static_cast<SampleType>(static_cast<juce::int32>(phase)) * scale;
+
+        if constexpr (W == Sine)
+            return sine(static_cast<SampleType>(0.5) * x);
+        else if constexpr (W == Triangle)
+            return 1 - 2 * std::abs(x);                         // 2*|2phi-1| - 1
+        else if constexpr (W == SawUp)
+            return static_cast<SampleType>(static_cast<juce::int32>(phase ^ 0x80000000u)) * scale;  // 2phi - 1
+        else if constexpr (W == SawDown)
+            return -static_cast<SampleType>(static_cast<juce::int32>(phase ^ 0x80000000u)) * scale; // 1 - 2phi
+        else
+            return (x >= 0) ? SampleType(1) : SampleType(-1);   // phi < 0.5
+    }
+
+    // sin(2*pi*t) per t in [-0.5,0.5): ripiegamento su [-0.25,0.25] e polinomio dispari
+    // di grado 7 (minimax). Errore massimo rispetto a std::sin: 7.4e-7 (circa -122 dB),
+    // ampiamente sotto la risoluzione del ritardo anche nel percorso double
+    static inline SampleType sine(SampleType t) noexcept
+    {
+        constexpr auto half = static_cast<SampleType>(0.5);
+        constexpr auto c1 = static_cast<SampleType>(6.283164024), c3 = static_cast<SampleType>(-41.33714294);
+        constexpr auto c5 = static_cast<SampleType>(81.34077454), c7 = static_cast<SampleType>(-70.99345398);
+
+        const SampleType u = juce::jmax(juce::jmin(t, half - t), -half - t);
+        const SampleType u2 = u * u;
+
+        return u * (c1 + u2 * (c3 + u2 * (c5 + u2 * c7)));
+    }
+
+    inline juce::uint32 getPhaseIncrement(SampleType hz) const noexcept
     {
-        x -= std::floor(x);
-        return x;
+        return static_cast<juce::uint32>(hz * phaseScale + static_cast<SampleType>(0.5));
     }
 
     Waveform waveform;
-    juce::SmoothedValue<double, juce::ValueSmoothingTypes::Multiplicative> frequency;
-    double currentPhase{ 0.0 };
-    double samplingPeriod{ 0.0 };
+    BlockSmoothedValue<SampleType, juce::ValueSmoothingTypes::Multiplicative> frequency;
+    juce::uint32 currentPhase{ 0 };
+    SampleType phaseScale{ 0 };          // 2^32 / sample rate: incremento di fase per Hz
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(NaiveOscillator)
 };
@@ -85,76 +222,282 @@ private:
 //                       ParameterModulation
 //==============================================================
 
+template <typename SampleType>
 class ParameterModulation
 {
 public:
-    ParameterModulation(double defaultParameter = 0.0,
-        double defaultModAmount = 0.0,
-        double defaultPhaseDelta = 0.0)
+    using Oscillator = NaiveOscillator<SampleType>;
+
+    ParameterModulation(SampleType defaultParameter = 0,
+        SampleType defaultModAmount = 0,
+        SampleType defaultPhaseDelta = 0)
     {
         parameter.setCurrentAndTargetValue(defaultParameter);
         modAmount.setCurrentAndTargetValue(defaultModAmount);
         phaseDelta.setCurrentAndTargetValue(defaultPhaseDelta);
     }
 
-    void prepareToPlay(double sampleRate)
+    void prepareToPlay(double sampleRate, int maxNumSamples)
+    {
+        parameter.setMaximumBlockSize(maxNumSamples);
+        modAmount.setMaximumBlockSize(maxNumSamples);
+        setSampleRate(sampleRate);
+    }
+
+    // Cambia sample rate (fattore di oversampling) senza allocare
+    void setSampleRate(double sampleRate)
     {
         parameter.reset(sampleRate, 0.02);
         modAmount.reset(sampleRate, 0.02);
         phaseDelta.reset(sampleRate, 0.02);
-        samplingPeriod = 1.0 / sampleRate;
     }
 
-    void setParameter(double newValue) { parameter.setTargetValue(newValue); }
-    void setModAmount(double newValue) { modAmount.setTargetValue(newValue); }
-    void setPhaseDelta(double newValue) { phaseDelta.setTargetValue(newValue); }
+    void setParameter(SampleType newValue) { parameter.setTargetValue(newValue); }
+    void setModAmount(SampleType newValue) { modAmount.setTargetValue(newValue); }
+    void setPhaseDelta(SampleType newValue) { phaseDelta.setTargetValue(newValue); }
+
+    void snapToTargets() noexcept
+    {
+        parameter.snapToTarget();
+        modAmount.snapToTarget();
+        phaseDelta.setCurrentAndTargetValue(phaseDelta.getTargetValue());
+    }
+
+    SampleType getModAmount() const noexcept { return modAmount.getTargetValue(); }
+
+    // Modalità multi-voce: numVoices uscite per canale (potenza di due). L'uscita i è la voce
+    // i % numVoices del canale i / numVoices; le voci di un canale sono equidistanti sul ciclo
+    // dell'LFO e ognuna ha la sua profondità (VOICE_DEPTH_SPREAD), la prima è quella del canale
+    void setNumVoices(int newNumVoices) noexcept
+    {
+        jassert(newNumVoices >= 1 && juce::isPowerOfTwo(newNumVoices));
+
+        numVoices = juce::jmax(1, newNumVoices);
+        voiceShift = juce::findHighestSetBit(static_cast<juce::uint32>(numVoices));
+        voiceSpacing = Oscillator::cyclesToPhase(1.0 / numVoices);
+        voiceDepthStep = static_cast<SampleType>(VOICE_DEPTH_SPREAD / numVoices);
+    }
 
-    double getModAmount() const noexcept { return modAmount.getTargetValue(); }
+    int getNumVoices() const noexcept { return numVoices; }
 
-    // Riempie un buffer stereo di valori modulati
-    void process(juce::AudioBuffer<float>& modulationBuffer, NaiveOscillator& lfo)
+    // Tutti i canali alla stessa fase dell'LFO (Phase Delta fermo a zero o a un ciclo intero)
+    bool isPhaseAligned() const noexcept
     {
-        const int numCh = modulationBuffer.getNumChannels();
+        return !phaseDelta.isSmoothing() && Oscillator::cyclesToPhase(phaseDelta.getTargetValue()) == 0;
+    }
+
+    // Valore modulato corrente di ogni uscita (numChannels * numVoices, come processBlock),
+    // senza avanzare LFO e smoothing
+    void getCurrentValues(const Oscillator& lfo, SampleType* modulated, int numChannels) const noexcept
+    {
+        const juce::uint32 phiMain = lfo.getPhase();
+        const juce::uint32 spacing = Oscillator::cyclesToPhase(phaseDelta.getCurrentValue());
+
+        const SampleType amt = modAmount.getCurrentValue();
+        const SampleType base = parameter.getCurrentValue();
+
+        for (int i = 0; i < numChannels * numVoices; ++i)
+            modulated[i] = base + amt * (getOutputDepth(i) * lfo.generateSample(getOutputPhase(phiMain, spacing, i)));
+    }
+
+    // Avanza LFO e smoothing di numSamples campioni senza produrre modulazione
+    void skip(Oscillator& lfo, int numSamples) noexcept
+    {
+        lfo.advancePhase(numSamples);
+        parameter.skip(numSamples);
+        modAmount.skip(numSamples);
+        phaseDelta.skip(numSamples);
+    }
+
+    // Riempie un buffer di valori modulati, un canale del buffer per uscita (canale, o canale e voce);
+    // lfoBuffer (opzionale) riceve anche l'LFO puro [-1..1] di ciascun canale, per altre destinazioni (cutoff del filtro)
+    void process(juce::AudioBuffer<SampleType>& modulationBuffer, Oscillator& lfo,
+        juce::AudioBuffer<SampleType>* lfoBuffer = nullptr)
+    {
+        const int numOutputs = modulationBuffer.getNumChannels();
         const int numSamples = modulationBuffer.getNumSamples();
+        const int numLfoCh = lfoBuffer != nullptr ? juce::jmin(lfoBuffer->getNumChannels(), numOutputs >> voiceShift) : 0;
 
-        jassert(numCh >= 1);
+        jassert(numOutputs >= numVoices && numOutputs % numVoices == 0);
 
-        for (int s = 0; s < numSamples; ++s)
+        auto modulationData = modulationBuffer.getArrayOfWritePointers();
+
+        if (phaseDelta.isSmoothing())
         {
-            const double phiMain = lfo.getCurrentPhase();
-            const double phiOffset = wrap01(phiMain + phaseDelta.getNextValue());
+            // Sfasamento in rampa: percorso per-campione
+            for (int s = 0; s < numSamples; ++s)
+                nextSample(lfo, numOutputs, [&](int i, SampleType modulated, SampleType lfoValue)
+                    {
+                        modulationData[i][s] = modulated;
 
-            // LFO puro [-1..1]
-            const double lfoL = lfo.generateSample(phiMain);
-            const double lfoR = lfo.generateSample(phiOffset);
+                        if (isLfoOutput(i, numLfoCh))
+                            lfoBuffer->setSample(i >> voiceShift, s, lfoValue);
+                    });
+            return;
+        }
 
-            // Parametri smoothed
-            const double amt = modAmount.getNextValue();
-            const double base = parameter.getNextValue();
+        // LFO puro [-1..1] di tutte le uscite in un solo passaggio, i canali sfasati di Phase Delta l'uno dall'altro
+        const juce::uint32 spacing = Oscillator::cyclesToPhase(phaseDelta.getTargetValue());
+        lfo.renderBlockAt(modulationData, numOutputs, [this, spacing](int i) { return getOutputPhase(0, spacing, i); }, numSamples);
 
-            // Valore modulato: base + LFO * amount
-            const double modulatedL = base + amt * lfoL;
-            const double modulatedR = base + amt * lfoR;
+        for (int ch = 0; ch < numLfoCh; ++ch)
+            lfoBuffer->copyFrom(ch, 0, modulationBuffer, ch << voiceShift, 0, numSamples);
 
-            if (numCh >= 1)
-                modulationBuffer.getWritePointer(0)[s] = static_cast<float>(modulatedL);
+        // Profondità delle voci (la prima di ogni canale resta a 1)
+        for (int i = 0; i < numOutputs; ++i)
+            if (getOutputDepth(i) != 1)
+                juce::FloatVectorOperations::multiply(modulationData[i], getOutputDepth(i), numSamples);
 
-            if (numCh >= 2)
-                modulationBuffer.getWritePointer(1)[s] = static_cast<float>(modulatedR);
+        // Valore modulato: base + LFO * amount, rampe calcolate una volta per tutti i canali
+        const auto base = parameter.process(numSamples);
+        const auto amt = modAmount.process(numSamples);
 
-            lfo.advancePhase();
-        }
+        visitSmoothedBlocks(base, amt, [&](auto baseValues, auto amtValues)
+            {
+                for (int i = 0; i < numOutputs; ++i)
+                    applyAmount(modulationData[i], baseValues, amtValues, numSamples);
+            });
+    }
+
+    // Un campione di modulazione per numChannels canali, poi avanza l'LFO (una voce per canale).
+    // lfoValues (opzionale, numChannels valori) riceve l'LFO puro di ciascun canale
+    inline void processSample(Oscillator& lfo, SampleType* modulated, int numChannels, SampleType* lfoValues = nullptr) noexcept
+    {
+        jassert(numVoices == 1);
+
+        nextSample(lfo, numChannels, [modulated, lfoValues](int ch, SampleType value, SampleType lfoValue)
+            {
+                modulated[ch] = value;
+
+                if (lfoValues != nullptr)
+                    lfoValues[ch] = lfoValue;
+            });
+    }
+
+    // Control rate: un punto di controllo per uscita ogni controlInterval campioni.
+    // Il punto k è il valore all'ultimo campione del k-esimo segmento (l'ultimo segmento
+    // può essere più corto); Delays interpola la traiettoria tra un punto e l'altro.
+    void processControlRate(juce::AudioBuffer<SampleType>& controlPoints, Oscillator& lfo, int numSamples, int controlInterval,
+        juce::AudioBuffer<SampleType>* lfoPoints = nullptr)
+    {
+        const int numOutputs = controlPoints.getNumChannels();
+        const int numLfoCh = lfoPoints != nullptr ? juce::jmin(lfoPoints->getNumChannels(), numOutputs >> voiceShift) : 0;
+
+        jassert(numOutputs >= numVoices && numOutputs % numVoices == 0);
+        jassert(controlInterval >= 1);
+        jassert(controlPoints.getNumSamples() >= (numSamples + controlInterval - 1) / controlInterval);
+
+        auto pointData = controlPoints.getArrayOfWritePointers();
+
+        for (int start = 0, k = 0; start < numSamples; start += controlInterval, ++k)
+            nextControlPoint(lfo, juce::jmin(controlInterval, numSamples - start), numOutputs, [&](int i, SampleType modulated, SampleType lfoValue)
+                {
+                    pointData[i][k] = modulated;
+
+                    if (isLfoOutput(i, numLfoCh))
+                        lfoPoints->setSample(i >> voiceShift, k, lfoValue);
+                });
+    }
+
+    // Avanza LFO e smoothing di numSamples campioni e restituisce il valore modulato
+    // dell'ultimo campione del segmento per numChannels canali, lo stesso che darebbe processSample
+    inline void processControlPoint(Oscillator& lfo, int numSamples, SampleType* modulated, int numChannels,
+        SampleType* lfoValues = nullptr) noexcept
+    {
+        jassert(numVoices == 1);
+
+        nextControlPoint(lfo, numSamples, numChannels, [modulated, lfoValues](int ch, SampleType value, SampleType lfoValue)
+            {
+                modulated[ch] = value;
+
+                if (lfoValues != nullptr)
+                    lfoValues[ch] = lfoValue;
+            });
+    }
+
+    // Fase dell'LFO del canale ch: il canale 0 segue l'LFO, ogni canale successivo
+    // è sfasato di Phase Delta rispetto al precedente (in stereo il destro di Phase Delta)
+    static inline juce::uint32 getChannelPhase(juce::uint32 phiMain, juce::uint32 spacing, int ch) noexcept
+    {
+        return phiMain + static_cast<juce::uint32>(ch) * spacing;
+    }
+
+    // Fase e profondità dell'uscita i (con una voce: il canale i, profondità 1)
+    inline juce::uint32 getOutputPhase(juce::uint32 phiMain, juce::uint32 spacing, int i) const noexcept
+    {
+        return getChannelPhase(phiMain, spacing, i >> voiceShift) + static_cast<juce::uint32>(i & (numVoices - 1)) * voiceSpacing;
+    }
+
+    inline SampleType getOutputDepth(int i) const noexcept
+    {
+        return 1 - voiceDepthStep * static_cast<SampleType>(i & (numVoices - 1));
     }
 
 private:
-    static inline double wrap01(double x) noexcept
+    // Un campione: output(uscita, valore modulato, LFO puro) per ogni uscita, poi avanza l'LFO
+    template <typename Output>
+    inline void nextSample(Oscillator& lfo, int numOutputs, Output&& output) noexcept
     {
-        x -= std::floor(x);
-        return x;
+        const juce::uint32 phiMain = lfo.getPhase();
+        const juce::uint32 spacing = Oscillator::cyclesToPhase(phaseDelta.getNextValue());
+
+        // Parametri smoothed
+        const SampleType amt = modAmount.getNextValue();
+        const SampleType base = parameter.getNextValue();
+
+        // Valore modulato: base + LFO * amount (numOutputs uscite, canali o voci)
+        for (int i = 0; i < numOutputs; ++i)
+        {
+            const SampleType lfoValue = lfo.generateSample(getOutputPhase(phiMain, spacing, i));
+            output(i, base + amt * (getOutputDepth(i) * lfoValue), lfoValue);
+        }
+
+        lfo.advancePhase();
     }
 
-    juce::SmoothedValue<double, juce::ValueSmoothingTypes::Linear> parameter;
-    juce::SmoothedValue<double, juce::ValueSmoothingTypes::Linear> modAmount;
-    juce::SmoothedValue<double, juce::ValueSmoothingTypes::Linear> phaseDelta;
-    double samplingPeriod{ 0.0 };
+    template <typename Output>
+    inline void nextControlPoint(Oscillator& lfo, int numSamples, int numOutputs, Output&& output) noexcept
+    {
+        jassert(numSamples >= 1);
+
+        lfo.advancePhase(numSamples - 1);
+
+        const juce::uint32 phiMain = lfo.getPhase();
+        const juce::uint32 spacing = Oscillator::cyclesToPhase(phaseDelta.skip(numSamples));
+
+        const SampleType amt = modAmount.skip(numSamples);
+        const SampleType base = parameter.skip(numSamples);
+
+        for (int i = 0; i < numOutputs; ++i)
+        {
+            const SampleType lfoValue = lfo.generateSample(getOutputPhase(phiMain, spacing, i));
+            output(i, base + amt * (getOutputDepth(i) * lfoValue), lfoValue);
+        }
+
+        lfo.advancePhase();
+    }
+
+    // Uscita con l'LFO puro di un canale (prima voce) richiesto da lfoBuffer/lfoPoints
+    inline bool isLfoOutput(int i, int numLfoChannels) const noexcept
+    {
+        return (i & (numVoices - 1)) == 0 && (i >> voiceShift) < numLfoChannels;
+    }
+
+    // Base e Amount: SmoothedBlock::Constant o SmoothedBlock::Ramp
+    template <typename Base, typename Amount>
+    static void applyAmount(SampleType* data, Base base, Amount amt, int numSamples) noexcept
+    {
+        for (int s = 0; s < numSamples; ++s)
+            data[s] = base[s] + amt[s] * data[s];
+    }
+
+    BlockSmoothedValue<SampleType> parameter;
+    BlockSmoothedValue<SampleType> modAmount;
+    juce::SmoothedValue<SampleType, juce::ValueSmoothingTypes::Linear> phaseDelta;
+
+    // Voci per canale (multi-voce)
+    int numVoices = 1;
+    int voiceShift = 0;                     // log2(numVoices)
+    juce::uint32 voiceSpacing = 0;          // sfasamento tra voci consecutive
+    SampleType voiceDepthStep = 0;          // riduzione di profondità da una voce alla successiva
 };
@@ -2,6 +2,50 @@
 
 #include <JuceHeader.h>
 
+// ===== CACHE DEI LAYER STATICI =====
+// Parti che non dipendono dal valore o dallo stato (corpo del knob, ombra dei pulsanti) renderizzate
+// una volta in un'immagine per dimensione e scala del display: ai repaint successivi si copia l'immagine.
+// Solo thread dei messaggi.
+class LayerCache
+{
+public:
+    // paintLayer(g, area) disegna il layer in un'area con origine (0, 0) e le dimensioni di area
+    template <typename Painter>
+    void draw(juce::Graphics& g, juce::Rectangle<float> area, Painter&& paintLayer)
+    {
+        const float scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+        const int width = juce::jmax(1, juce::roundToInt(area.getWidth() * scale));
+        const int height = juce::jmax(1, juce::roundToInt(area.getHeight() * scale));
+        const Key key{ width, height, juce::roundToInt(scale * 100.0f) };
+
+        auto cached = images.find(key);
+        if (cached == images.end())
+        {
+            // Poche combinazioni in pratica; il limite evita di crescere con resize continui
+            if (images.size() >= maxImages)
+                images.clear();
+
+            juce::Image image(juce::Image::ARGB, width, height, true);
+            {
+                juce::Graphics layer(image);
+                layer.addTransform(juce::AffineTransform::scale((float)width / area.getWidth(), (float)height / area.getHeight()));
+                paintLayer(layer, area.withZeroOrigin());
+            }
+            cached = images.emplace(key, image).first;
+        }
+
+        g.setOpacity(1.0f);
+        g.drawImage(cached->second, area);
+    }
+
+    void clear() { images.clear(); }
+
+private:
+    using Key = std::tuple<int, int, int>;   // larghezza, altezza (pixel fisici), scala * 100
+    static constexpr size_t maxImages = 16;
+    std::map<Key, juce::Image> images;
+};
+
 // ===== KNOB =====
 class KnobLookAndFeel : public juce::LookAndFeel_V4
 {
@@ -41,19 +85,11 @@ public:
 
         auto currentAngle = rotaryStartAngle + sliderPosProportional * (rotaryEndAngle - rotaryStartAngle);
 
-        g.setColour(knobShadow.withAlpha(0.6f));
-        g.fillEllipse(bounds.translated(3, 3).expanded(2));
-
-        juce::ColourGradient faceGrad(knobFace.darker(0.15f), bounds.getCentre(),
-            knobFace.darker(0.35f), bounds.getBottomRight(), true);
-        g.setGradientFill(faceGrad);
-        g.fillEllipse(bounds);
-
-        g.setColour(knobEdge.darker(0.2f));
-        g.drawEllipse(bounds, 6.0f);
-
-        g.setColour(knobShadow.withAlpha(0.2f));
-        g.drawEllipse(bounds.reduced(3.0f), 4.0f);
+        // Corpo del knob (ombra, faccia, bordi): uguale per ogni valore, dalla cache
+        bodyCache.draw(g, bounds.expanded(bodyMargin), [this](juce::Graphics& layer, juce::Rectangle<float> area)
+            {
+                drawKnobBody(layer, area.reduced(bodyMargin));
+            });
 
         juce::Path arc;
         arc.addCentredArc(centreX, centreY, radius + 3.0f, radius + 3.0f,
@@ -93,7 +129,28 @@ public:
     }
 
 private:
+    // Margine oltre il cerchio occupato da ombra (+5) e bordo (+3)
+    static constexpr float bodyMargin = 6.0f;
+
+    void drawKnobBody(juce::Graphics& g, juce::Rectangle<float> bounds) const
+    {
+        g.setColour(knobShadow.withAlpha(0.6f));
+        g.fillEllipse(bounds.translated(3, 3).expanded(2));
+
+        juce::ColourGradient faceGrad(knobFace.darker(0.15f), bounds.getCentre(),
+            knobFace.darker(0.35f), bounds.getBottomRight(), true);
+        g.setGradientFill(faceGrad);
+        g.fillEllipse(bounds);
+
+        g.setColour(knobEdge.darker(0.2f));
+        g.drawEllipse(bounds, 6.0f);
+
+        g.setColour(knobShadow.withAlpha(0.2f));
+        g.drawEllipse(bounds.reduced(3.0f), 4.0f);
+    }
+
     juce::Colour background, knobFace, knobEdge, knobShadow, knobArc, textColour;
+    LayerCache bodyCache;
 };
 
 class CustomButtonLookAndFeel : public juce::LookAndFeel_V4
@@ -105,9 +162,12 @@ public:
     {
         auto bounds = button.getLocalBounds().toFloat().reduced(1.0f);
 
-        // Ombra
-        juce::DropShadow shadow(juce::Colours::black.withAlpha(0.5f), 4, { 2, 2 });
-        shadow.drawForRectangle(g, bounds.getSmallestIntegerContainer());
+        // Ombra (sfocatura costosa: dalla cache, una per dimensione del pulsante)
+        shadowCache.draw(g, bounds.expanded(shadowMargin), [](juce::Graphics& layer, juce::Rectangle<float> area)
+            {
+                juce::DropShadow shadow(juce::Colours::black.withAlpha(0.5f), 4, { 2, 2 });
+                shadow.drawForRectangle(layer, area.reduced(shadowMargin).getSmallestIntegerContainer());
+            });
 
         // Corpo pulsante
         juce::Colour base = button.getToggleState() ? juce::Colours::orange : juce::Colours::darkgrey;
@@ -121,6 +181,11 @@ public:
         g.setColour(juce::Colours::black);
         g.drawRoundedRectangle(bounds, 6.0f, 1.5f);
     }
+
+private:
+    // Raggio + offset dell'ombra
+    static constexpr float shadowMargin = 6.0f;
+    LayerCache shadowCache;
 };
 
 // ===== TOGGLE BUTTON LOOK AND FEEL CON SIMBOLI (Waveform + Filter) =====
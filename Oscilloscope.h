@@ -0,0 +1,161 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "Telemetry.h"
+
+// ===== OSCILLOSCOPIO =====
+// Ultimi historySize punti della TelemetryTap: ingresso e uscita (media dei canali),
+// delay modulato dei due canali (traiettoria dell'LFO) e meter di picco ingresso/uscita.
+// update() va chiamato dal thread dei messaggi a ogni refresh del display (VBlankAttachment):
+// svuota la FIFO e ridisegna solo se sono arrivati punti o i meter stanno ancora scendendo.
+class Oscilloscope : public juce::Component
+{
+public:
+    static constexpr int historySize = 1024;
+
+    explicit Oscilloscope(TelemetryTap& tapToRead)
+        : tap(tapToRead)
+    {
+        setOpaque(false);
+        setInterceptsMouseClicks(false, false);
+    }
+
+    void update()
+    {
+        const double now = juce::Time::getMillisecondCounterHiRes();
+        const double elapsedSeconds = lastUpdateMs > 0.0 ? (now - lastUpdateMs) * 0.001 : 0.0;
+        lastUpdateMs = now;
+
+        // Discesa dei meter: 20 dB al secondo
+        const float decay = static_cast<float>(std::pow(10.0, -elapsedSeconds));
+        bool changed = false;
+
+        for (auto& level : meterLevels)
+        {
+            changed = changed || level > 0.0001f;
+            level *= decay;
+        }
+
+        for (;;)
+        {
+            const int numRead = tap.read(readBuffer.data(), static_cast<int>(readBuffer.size()));
+            if (numRead == 0)
+                break;
+
+            for (int i = 0; i < numRead; ++i)
+            {
+                const auto& point = readBuffer[(size_t)i];
+                history[(size_t)writeIndex] = point;
+                writeIndex = (writeIndex + 1) % historySize;
+
+                for (int ch = 0; ch < 2; ++ch)
+                {
+                    meterLevels[(size_t)ch] = juce::jmax(meterLevels[(size_t)ch], point.inputPeak[ch]);
+                    meterLevels[(size_t)(ch + 2)] = juce::jmax(meterLevels[(size_t)(ch + 2)], point.outputPeak[ch]);
+                }
+            }
+
+            changed = true;
+        }
+
+        if (changed)
+            repaint();
+    }
+
+    void paint(juce::Graphics& g) override
+    {
+        auto bounds = getLocalBounds().toFloat();
+        auto meterArea = bounds.removeFromRight(52.0f);
+        auto traceArea = bounds.reduced(2.0f);
+
+        g.setColour(juce::Colours::black.withAlpha(0.35f));
+        g.fillRoundedRectangle(traceArea, 4.0f);
+
+        g.setColour(juce::Colours::grey.withAlpha(0.3f));
+        g.drawHorizontalLine(juce::roundToInt(traceArea.getCentreY()), traceArea.getX(), traceArea.getRight());
+
+        // Ingresso e uscita: media dei canali, fondo scala ±1
+        drawTrace(g, traceArea, juce::Colours::grey.withAlpha(0.7f), -1.0f, 1.0f,
+            [](const TelemetryTap::Point& p) { return 0.5f * (p.input[0] + p.input[1]); });
+        drawTrace(g, traceArea, juce::Colours::antiquewhite, -1.0f, 1.0f,
+            [](const TelemetryTap::Point& p) { return 0.5f * (p.output[0] + p.output[1]); });
+
+        // Delay modulato: scala adattata all'escursione visibile
+        float minMs = std::numeric_limits<float>::max(), maxMs = std::numeric_limits<float>::lowest();
+        for (const auto& point : history)
+            for (int ch = 0; ch < 2; ++ch)
+            {
+                minMs = juce::jmin(minMs, point.modulation[ch]);
+                maxMs = juce::jmax(maxMs, point.modulation[ch]);
+            }
+
+        const float marginMs = juce::jmax(0.1f, (maxMs - minMs) * 0.1f);
+        drawTrace(g, traceArea, juce::Colour::fromRGB(240, 190, 60), minMs - marginMs, maxMs + marginMs,
+            [](const TelemetryTap::Point& p) { return p.modulation[0]; });
+        drawTrace(g, traceArea, juce::Colour::fromRGB(120, 200, 220), minMs - marginMs, maxMs + marginMs,
+            [](const TelemetryTap::Point& p) { return p.modulation[1]; });
+
+        g.setFont(11.0f);
+        g.setColour(juce::Colours::antiquewhite.withAlpha(0.7f));
+        g.drawText(juce::String(maxMs, 2) + " ms", traceArea.reduced(4.0f), juce::Justification::topLeft, false);
+        g.drawText(juce::String(minMs, 2) + " ms", traceArea.reduced(4.0f), juce::Justification::bottomLeft, false);
+
+        drawMeters(g, meterArea.reduced(4.0f, 2.0f));
+    }
+
+private:
+    template <typename Value>
+    void drawTrace(juce::Graphics& g, juce::Rectangle<float> area, juce::Colour colour, float minValue, float maxValue, Value value) const
+    {
+        juce::Path path;
+        const float xScale = area.getWidth() / static_cast<float>(historySize - 1);
+        const float range = juce::jmax(1.0e-6f, maxValue - minValue);
+
+        for (int i = 0; i < historySize; ++i)
+        {
+            // Dal punto più vecchio al più recente
+            const auto& point = history[(size_t)((writeIndex + i) % historySize)];
+            const float normalised = juce::jlimit(0.0f, 1.0f, (value(point) - minValue) / range);
+            const float x = area.getX() + static_cast<float>(i) * xScale;
+            const float y = area.getBottom() - normalised * area.getHeight();
+
+            if (i == 0)
+                path.startNewSubPath(x, y);
+            else
+                path.lineTo(x, y);
+        }
+
+        g.setColour(colour);
+        g.strokePath(path, juce::PathStrokeType(1.2f));
+    }
+
+    // Quattro barre (ingresso L/R, uscita L/R), scala -60..0 dBFS
+    void drawMeters(juce::Graphics& g, juce::Rectangle<float> area) const
+    {
+        const float barWidth = area.getWidth() / 4.0f;
+
+        for (int i = 0; i < 4; ++i)
+        {
+            auto bar = juce::Rectangle<float>(area.getX() + barWidth * static_cast<float>(i), area.getY(), barWidth - 2.0f, area.getHeight());
+            const float db = juce::Decibels::gainToDecibels(meterLevels[(size_t)i], -60.0f);
+            const float proportion = juce::jmap(db, -60.0f, 0.0f, 0.0f, 1.0f);
+
+            g.setColour(juce::Colours::black.withAlpha(0.5f));
+            g.fillRect(bar);
+
+            g.setColour(meterLevels[(size_t)i] >= 1.0f ? juce::Colours::red
+                                                      : (i < 2 ? juce::Colours::grey : juce::Colours::antiquewhite));
+            g.fillRect(bar.withTop(bar.getBottom() - proportion * bar.getHeight()));
+        }
+    }
+
+    TelemetryTap& tap;
+    std::array<TelemetryTap::Point, historySize> history{};
+    std::array<TelemetryTap::Point, 256> readBuffer{};
+    int writeIndex = 0;
+
+    std::array<float, 4> meterLevels{};
+    double lastUpdateMs = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(Oscilloscope)
+};
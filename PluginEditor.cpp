@@ -10,22 +10,46 @@
 // Costruttore
 FlangerAudioProcessorEditor::FlangerAudioProcessorEditor(FlangerAudioProcessor& p,
     juce::AudioProcessorValueTreeState& vts)
-    : AudioProcessorEditor(&p), audioProcessor(p), valueTreeState(vts)
+    : AudioProcessorEditor(&p), audioProcessor(p), valueTreeState(vts),
+    scope(p.getTelemetry()),
+    analyzer(p.getSpectrumTap(), vts),
+    vblank(this, [this] { scope.update(); analyzer.update(); })
 {
-    setSize(750, 550);
-    startTimerHz(10); //per aggiornare 10 volte al secondo
+    setSize(750, 700);
+    setOpaque(true);
+    startTimerHz(10); //per aggiornare 10 volte al secondo (undo/redo, carico DSP)
 
     // ====== AREE =======
     delayArea = { 20, 60, 320, 200 };
     modArea = { 370, 60, 360, 200 };
     filterArea = { 20, 300, 320, 200 };
     mixArea = { 370, 300, 360, 200 };
+    scopeArea = { 20, 530, 320, 125 };
+    analyzerArea = { 370, 530, 360, 125 };
 
     // ====== DELAY GROUP ======
     setupSlider(delaySlider, "Delay", Parameters::nameDelayTime,
-        delayArea.getX() + 45, delayArea.getCentreY() - 55);
+        delayArea.getX() + 45, delayArea.getCentreY() - 85);
     setupSlider(feedbackSlider, "Feedback", Parameters::nameFeedback,
-        delayArea.getRight() - 155, delayArea.getCentreY() - 55);
+        delayArea.getRight() - 155, delayArea.getCentreY() - 85);
+
+    // Interpolatore del ritardo frazionario, voci prese dal parametro
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(valueTreeState.getParameter(Parameters::nameInterpolation)))
+        interpolationBox.addItemList(choice->choices, 1);
+
+    interpolationBox.setBounds(delayArea.getX() + 20, delayArea.getBottom() - 50, 150, 28);
+    addAndMakeVisible(interpolationBox);
+    interpolationAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        valueTreeState, Parameters::nameInterpolation, interpolationBox);
+
+    // Voci sulla stessa linea di delay (multi-voce)
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(valueTreeState.getParameter(Parameters::nameVoices)))
+        voicesBox.addItemList(choice->choices, 1);
+
+    voicesBox.setBounds(delayArea.getRight() - 80, delayArea.getBottom() - 50, 60, 28);
+    addAndMakeVisible(voicesBox);
+    voicesAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        valueTreeState, Parameters::nameVoices, voicesBox);
 
     // ====== MODULATION GROUP ======
     setupSlider(modFrequencySlider, "Rate", Parameters::nameModFrequency,
@@ -70,9 +94,18 @@ FlangerAudioProcessorEditor::FlangerAudioProcessorEditor(FlangerAudioProcessor&
 
     // ====== MIX GROUP ======
     setupSlider(dryWetSlider, "Mix", Parameters::nameDryWet,
-        mixArea.getX() + 55, mixArea.getCentreY() - 55);
+        mixArea.getX() + 55, mixArea.getCentreY() - 85);
     setupSlider(outputGainSlider, "Gain", Parameters::nameOutputGain,
-        mixArea.getRight() - 155, mixArea.getCentreY() - 55);
+        mixArea.getRight() - 155, mixArea.getCentreY() - 85);
+
+    // Oversampling della sezione delay + filtro
+    if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(valueTreeState.getParameter(Parameters::nameOversampling)))
+        oversamplingBox.addItemList(choice->choices, 1);
+
+    oversamplingBox.setBounds(mixArea.getCentreX() + 10, mixArea.getBottom() - 50, 80, 28);
+    addAndMakeVisible(oversamplingBox);
+    oversamplingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(
+        valueTreeState, Parameters::nameOversampling, oversamplingBox);
 
     // ====== SET LOOKANDFEEL sui knob ======
     for (auto* s : { &delaySlider, &feedbackSlider, &modFrequencySlider, &modAmountSlider,&phasedeltaSlider,
@@ -113,12 +146,34 @@ FlangerAudioProcessorEditor::FlangerAudioProcessorEditor(FlangerAudioProcessor&
                     um->redo();
         };
 
+    // ====== SCOPE / ANALYZER ======
+    // Il processore invia i campioni solo mentre l'editor è aperto
+    scope.setBounds(scopeArea.reduced(12, 0).withTrimmedTop(22).withTrimmedBottom(10));
+    addAndMakeVisible(scope);
+    audioProcessor.getTelemetry().setEnabled(true);
+
+    analyzer.setBounds(analyzerArea.reduced(12, 0).withTrimmedTop(22).withTrimmedBottom(10));
+    addAndMakeVisible(analyzer);
+    audioProcessor.getSpectrumTap().setEnabled(true);
+
+#if FLANGER_DSP_PROFILING
+    // ====== CARICO DSP ======
+    loadLabel.setBounds(20, getHeight() - 44, getWidth() - 40, 36);
+    loadLabel.setFont(juce::Font("Courier New", 13.0f, juce::Font::plain));
+    loadLabel.setColour(juce::Label::textColourId, juce::Colours::antiquewhite.withAlpha(0.8f));
+    loadLabel.setJustificationType(juce::Justification::centred);
+    addAndMakeVisible(loadLabel);
+#endif
+
 }
 
 //==============================================================================
 // Distruttore
 FlangerAudioProcessorEditor::~FlangerAudioProcessorEditor()
 {
+    audioProcessor.getTelemetry().setEnabled(false);
+    audioProcessor.getSpectrumTap().setEnabled(false);
+
     // Rimuove listener
     valueTreeState.removeParameterListener(Parameters::nameWaveform, this);
     valueTreeState.removeParameterListener(Parameters::nameFilterType, this);
@@ -140,8 +195,31 @@ FlangerAudioProcessorEditor::~FlangerAudioProcessorEditor()
 
 
 //==============================================================================
-// Disegno sfondo e gruppi
+// Disegno: lo sfondo non cambia, quindi ogni repaint (knob, scope, label) copia solo
+// la sua regione dall'immagine in cache
 void FlangerAudioProcessorEditor::paint(juce::Graphics& g)
+{
+#if FLANGER_DSP_PROFILING
+    frameTimer.begin();
+#endif
+
+    backgroundCache.draw(g, getLocalBounds().toFloat(), [this](juce::Graphics& layer, juce::Rectangle<float>)
+        {
+            paintBackground(layer);
+        });
+}
+
+#if FLANGER_DSP_PROFILING
+// Chiamato dopo il disegno dei figli: chiude il passaggio misurato
+void FlangerAudioProcessorEditor::paintOverChildren(juce::Graphics&)
+{
+    frameTimer.end();
+}
+#endif
+
+//==============================================================================
+// Sfondo e gruppi
+void FlangerAudioProcessorEditor::paintBackground(juce::Graphics& g)
 {
     auto bounds = getLocalBounds();
 
@@ -173,6 +251,8 @@ void FlangerAudioProcessorEditor::paint(juce::Graphics& g)
     drawGroupBox(g, modArea, "Modulation");
     drawGroupBox(g, filterArea, "Filter");
     drawGroupBox(g, mixArea, "Mix");
+    drawGroupBox(g, scopeArea, "Scope");
+    drawGroupBox(g, analyzerArea, "Spectrum");
 
     // === Label sotto ai knob ===
     auto drawLabel = [&](juce::Slider& s)
@@ -196,6 +276,15 @@ void FlangerAudioProcessorEditor::paint(juce::Graphics& g)
                      &filterCutoffSlider, &filterQualitySlider,
                      &dryWetSlider, &outputGainSlider })
         drawLabel(*s);
+
+    // Label a sinistra del selettore di oversampling
+    auto oversamplingLabel = oversamplingBox.getBounds().withX(mixArea.getCentreX() - 110).withWidth(110);
+    g.setColour(juce::Colours::antiquewhite);
+    g.drawFittedText("Oversampling", oversamplingLabel, juce::Justification::centred, 1);
+
+    // Label a sinistra del selettore delle voci
+    auto voicesLabel = voicesBox.getBounds().withX(interpolationBox.getRight()).withRight(voicesBox.getX());
+    g.drawFittedText("Voices", voicesLabel, juce::Justification::centred, 1);
 }
 
 
@@ -250,6 +339,7 @@ void FlangerAudioProcessorEditor::drawGroupBox(juce::Graphics& g, juce::Rectangl
 // Ridisegno
 void FlangerAudioProcessorEditor::resized()
 {
+    backgroundCache.clear();
 }
 
 //==============================================================================
@@ -375,4 +465,33 @@ void FlangerAudioProcessorEditor::timerCallback()
         undoButton.setEnabled(um->canUndo());
         redoButton.setEnabled(um->canRedo());
     }
+
+#if FLANGER_DSP_PROFILING
+    // Carico DSP: ultimo blocco, min/media/max e media degli stadi attivi (percentuale della durata del blocco)
+    const auto load = audioProcessor.getLoadMeter().getSnapshot();
+    juce::String text;
+
+    if (load.numBlocks > 0)
+    {
+        auto percent = [](double value) { return juce::String(value * 100.0, 1) + "%"; };
+
+        text << "DSP " << percent(load.lastLoad) << "  min " << percent(load.minLoad)
+             << "  avg " << percent(load.averageLoad) << "  max " << percent(load.maxLoad) << "  |";
+
+        for (int s = 0; s < DspLoadMeter::numStages; ++s)
+            if (load.stageLoad[(size_t)s] >= 0.0005)
+                text << "  " << DspLoadMeter::getStageName(s) << " " << percent(load.stageLoad[(size_t)s]);
+
+        // Blocchi oltre la scadenza (ultima classe dell'istogramma)
+        if (load.histogram.back() > 0)
+            text << "  |  overrun " << juce::String(load.histogram.back());
+    }
+
+    // Tempo di disegno dell'editor (sfondo + figli ridisegnati) nell'ultimo intervallo del timer
+    const auto frames = frameTimer.collect();
+    text << "\nUI paint avg " << juce::String(frames.averageMs, 2) << " ms  max " << juce::String(frames.maxMs, 2)
+         << " ms  " << juce::String(frames.framesPerSecond, 0) << " frames/s";
+
+    loadLabel.setText(text, juce::dontSendNotification);
+#endif
 }
@@ -3,6 +3,8 @@
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
 #include "MyTheme.h" 
+#include "Oscilloscope.h"
+#include "Analyzer.h"
 //==============================================================================
 class FlangerAudioProcessorEditor : public juce::AudioProcessorEditor,
     private juce::AudioProcessorValueTreeState::Listener,
@@ -13,6 +15,9 @@ public:
     ~FlangerAudioProcessorEditor() override;
 
     void paint(juce::Graphics&) override;
+#if FLANGER_DSP_PROFILING
+    void paintOverChildren(juce::Graphics&) override;
+#endif
     void resized() override;
     void timerCallback() override;
 
@@ -23,6 +28,7 @@ private:
         const juce::String& paramID, int x, int y);
     void setupButton(juce::TextButton& button, const juce::String& text, const juce::String& paramID, int x, int y, bool isWaveform, bool defaultSelected=false);
     
+    void paintBackground(juce::Graphics& g);
     void drawGroupBox(juce::Graphics& g, juce::Rectangle<int> area, const juce::String& title);
 
     void parameterChanged(const juce::String& parameterID, float newValue) override;
@@ -56,6 +62,11 @@ private:
     juce::TextButton bandpassButton;
     juce::TextButton filterActiveButton;
 
+    // === Interpolazione delay / Voci / Oversampling ===
+    juce::ComboBox interpolationBox;
+    juce::ComboBox oversamplingBox;
+    juce::ComboBox voicesBox;
+
     // === Attachments ===
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> delayAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> feedbackAttachment;
@@ -68,6 +79,9 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> outputGainAttachment;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> filterActiveAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> interpolationAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> oversamplingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> voicesAttachment;
 
     // === LookAndFeel instances ===
     KnobLookAndFeel knobLNF;
@@ -77,11 +91,27 @@ private:
     juce::TextButton undoButton{ "Undo" };
     juce::TextButton redoButton{ "Redo" };
 
+    // === Oscilloscopio e analizzatore (ridisegnati al refresh del display) ===
+    Oscilloscope scope;
+    SpectrumAnalyzer analyzer;
+    juce::VBlankAttachment vblank;
+
+    // === Sfondo statico (gradiente, gruppi, etichette) renderizzato una volta ===
+    LayerCache backgroundCache;
+
+#if FLANGER_DSP_PROFILING
+    // === Carico DSP e tempo di disegno (aggiornati dal timer) ===
+    juce::Label loadLabel;
+    EditorFrameTimer frameTimer;
+#endif
+
     // === Aree gruppi ===
     juce::Rectangle<int> delayArea;
     juce::Rectangle<int> modArea;
     juce::Rectangle<int> filterArea;
     juce::Rectangle<int> mixArea;
+    juce::Rectangle<int> scopeArea;
+    juce::Rectangle<int> analyzerArea;
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FlangerAudioProcessorEditor)
 };
@@ -6,6 +6,7 @@ namespace Parameters
     // Param Names
     static constexpr auto nameDelayTime = "delayTime";
     static constexpr auto nameFeedback = "feedback";
+    static constexpr auto nameInterpolation = "interpolation";
     static constexpr auto nameDryWet = "dryWet";
     static constexpr auto nameWaveform = "waveform";
     static constexpr auto nameModFrequency = "modFrequency";
@@ -15,11 +16,16 @@ namespace Parameters
     static constexpr auto nameQuality = "quality";
     static constexpr auto nameFilterType = "filterType";
     static constexpr auto nameFilterCutoff = "filterCutoff";
+    static constexpr auto nameFilterEngine = "filterEngine";
+    static constexpr auto nameFilterModDepth = "filterModDepth";
     static constexpr auto nameOutputGain = "outputGain";
+    static constexpr auto nameOversampling = "oversampling";
+    static constexpr auto nameVoices = "voices";
 
     // Defaults for Flanger
     static constexpr float defaultDelay = 5.0f;   // ms, tipico flanger corto
     static constexpr float defaultFeedback = 0.3f;   // 0..1
+    static constexpr int   defaultInterpolation = 0; // Linear
     static constexpr float defaultDryWet = 0.0f;   
     static constexpr int   defaultWaveform = 0;      // Sine
     static constexpr float defaultModFrequency = 0.25f; // Hz, lento per flanger
@@ -29,9 +35,20 @@ namespace Parameters
     static constexpr float defaultQuality = 0.707f; // 1/sqrt(2)
     static constexpr int   defaultFilterType = 0;      // LowPass
     static constexpr float defaultFilterCutoff = 2000.0f; // Hz
+    static constexpr int   defaultFilterEngine = 0;      // Biquad
+    static constexpr float defaultFilterModDepth = 0.0f; // ottave
     static constexpr float defaultOutputGain = 0.0f;   // dB
+    static constexpr int   defaultOversampling = 0;    // 1x
+    static constexpr int   defaultVoices = 0;          // 1 voce (flanger classico)
     static constexpr float dbFloor = -48.0f;
 
+    // Ranges (usati anche per dimensionare i buffer)
+    static constexpr float maxDelayTime = 20.0f;  // ms
+    static constexpr float maxModAmount = 1.0f;   // ms di escursione LFO
+    static constexpr float maxModFrequency = 5.0f; // Hz
+    static constexpr float maxFilterModDepth = 4.0f; // ottave di escursione del cutoff
+    static constexpr int   maxVoices = 16;            // prese modulate per linea di delay (2^scelta del parametro)
+
     // Parameter Layout
     inline juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout()
     {
@@ -43,11 +60,15 @@ namespace Parameters
 
         // ====== Flanger parameters ======
         params.emplace_back(std::make_unique<APF>(Parameters::nameDelayTime, "Delay Time (ms)",
-            juce::NormalisableRange<float>(0.1f, 20.0f, 0.01f, 0.5f), Parameters::defaultDelay));
+            juce::NormalisableRange<float>(0.1f, Parameters::maxDelayTime, 0.01f, 0.5f), Parameters::defaultDelay));
 
         params.emplace_back(std::make_unique<APF>(Parameters::nameFeedback, "Feedback",
             juce::NormalisableRange<float>(0.0f, 0.95f, 0.01f), Parameters::defaultFeedback));
 
+        params.emplace_back(std::make_unique<APC>(Parameters::nameInterpolation, "Interpolation",
+            juce::StringArray{ "Linear", "Cubic Hermite", "Lagrange 3", "Thiran Allpass", "Windowed Sinc" },
+            Parameters::defaultInterpolation));
+
         params.emplace_back(std::make_unique<APF>(Parameters::nameDryWet, "Dry/Wet",
             juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), Parameters::defaultDryWet));
 
@@ -56,10 +77,10 @@ namespace Parameters
             Parameters::defaultWaveform));
 
         params.emplace_back(std::make_unique<APF>(Parameters::nameModFrequency, "Mod Frequency (Hz)",
-            juce::NormalisableRange<float>(0.01f, 5.0f, 0.01f, 0.3f), Parameters::defaultModFrequency));
+            juce::NormalisableRange<float>(0.01f, Parameters::maxModFrequency, 0.01f, 0.3f), Parameters::defaultModFrequency));
 
         params.emplace_back(std::make_unique<APF>(Parameters::nameModAmount, "Mod Amount",
-            juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), Parameters::defaultModAmount));
+            juce::NormalisableRange<float>(0.0f, Parameters::maxModAmount, 0.01f), Parameters::defaultModAmount));
 
         params.emplace_back(std::make_unique<APF>(Parameters::namePhaseDelta, "Phase Delta",
             juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f), Parameters::defaultPhaseDelta));
@@ -77,31 +98,54 @@ namespace Parameters
         params.emplace_back(std::make_unique<APF>(Parameters::nameQuality, "Filter Quality (Q)",
             juce::NormalisableRange<float>(0.1f, 10.0f, 0.01f), Parameters::defaultQuality));
 
+        params.emplace_back(std::make_unique<APC>(Parameters::nameFilterEngine, "Filter Engine",
+            juce::StringArray{ "Biquad", "State Variable" }, Parameters::defaultFilterEngine));
+
+        params.emplace_back(std::make_unique<APF>(Parameters::nameFilterModDepth, "Filter LFO Depth (oct)",
+            juce::NormalisableRange<float>(0.0f, Parameters::maxFilterModDepth, 0.01f), Parameters::defaultFilterModDepth));
+
         // ====== Output parameters ======
         params.emplace_back(std::make_unique<APF>(Parameters::nameOutputGain, "Output Gain (dB)",
             juce::NormalisableRange<float>(Parameters::dbFloor, 12.0f, 0.5f), Parameters::defaultOutputGain));
 
-        return { params.begin(), params.end() };
-    }
+        params.emplace_back(std::make_unique<APC>(Parameters::nameOversampling, "Oversampling",
+            juce::StringArray{ "1x", "2x", "4x", "8x" }, Parameters::defaultOversampling));
 
-    // Utility per aggiungere/rimuovere listener
-    inline void addListenerToAllParameters(juce::AudioProcessorValueTreeState& vts, juce::AudioProcessorValueTreeState::Listener* listener)
-    {
-        for (auto* id : { nameDelayTime, nameFeedback, nameDryWet, nameWaveform, nameModFrequency,
-                          nameModAmount, namePhaseDelta, nameFilterActive, nameQuality,
-                          nameFilterType, nameFilterCutoff, nameOutputGain })
-        {
-            vts.addParameterListener(id, listener);
-        }
+        // ====== Voices ======
+        params.emplace_back(std::make_unique<APC>(Parameters::nameVoices, "Voices",
+            juce::StringArray{ "1", "2", "4", "8", "16" }, Parameters::defaultVoices));
+
+        return { params.begin(), params.end() };
     }
 
-    inline void removeListenerFromAllParameters(juce::AudioProcessorValueTreeState& vts, juce::AudioProcessorValueTreeState::Listener* listener)
+    // Indici dei parametri, nello stesso ordine di allIDs: il thread audio li usa
+    // per leggere e applicare i valori senza confronti tra stringhe
+    enum Index
     {
-        for (auto* id : { nameDelayTime, nameFeedback, nameDryWet, nameWaveform, nameModFrequency,
-                          nameModAmount, namePhaseDelta, nameFilterActive, nameQuality,
-                          nameFilterType, nameFilterCutoff, nameOutputGain })
-        {
-            vts.removeParameterListener(id, listener);
-        }
-    }
+        indexDelayTime = 0,
+        indexFeedback,
+        indexInterpolation,
+        indexDryWet,
+        indexWaveform,
+        indexModFrequency,
+        indexModAmount,
+        indexPhaseDelta,
+        indexFilterActive,
+        indexQuality,
+        indexFilterType,
+        indexFilterCutoff,
+        indexFilterEngine,
+        indexFilterModDepth,
+        indexOutputGain,
+        indexOversampling,
+        indexVoices,
+        numParameters
+    };
+
+    static constexpr const char* allIDs[numParameters] = {
+        nameDelayTime, nameFeedback, nameInterpolation, nameDryWet, nameWaveform, nameModFrequency,
+        nameModAmount, namePhaseDelta, nameFilterActive, nameQuality,
+        nameFilterType, nameFilterCutoff, nameFilterEngine, nameFilterModDepth, nameOutputGain, nameOversampling,
+        nameVoices
+    };
 }
@@ -2,37 +2,47 @@
 #include "PluginEditor.h"
 #include "PluginParameters.h"
 
+// Soglia di silenzio lineare (il pavimento di decibelsToGain va tenuto sotto la soglia)
+static float getSilenceThreshold() noexcept
+{
+    return juce::Decibels::decibelsToGain(SILENCE_THRESHOLD_DB, SILENCE_THRESHOLD_DB - 1.0f);
+}
+
 //==============================================================================
-// Costruttore
-FlangerAudioProcessor::FlangerAudioProcessor()
-    : parameters(*this, &undoManager, "FLG", Parameters::createParameterLayout()),
-    drywetter(Parameters::defaultDryWet),
-    delay(Parameters::defaultFeedback),
-    LFO(Parameters::defaultModFrequency, static_cast<NaiveOscillator::Waveform>(Parameters::defaultWaveform)),
+// Catena di una precisione
+template <typename SampleType>
+FlangerAudioProcessor::DspChain<SampleType>::DspChain()
+    : delay(Parameters::defaultFeedback),
+    drywetter(Parameters::defaultDryWet, Parameters::defaultOutputGain),
+    LFO(Parameters::defaultModFrequency, static_cast<typename NaiveOscillator<SampleType>::Waveform>(Parameters::defaultWaveform)),
     timeModulation(Parameters::defaultDelay, Parameters::defaultModAmount, Parameters::defaultPhaseDelta),
     filter(Parameters::defaultFilterCutoff, Parameters::defaultQuality, Parameters::defaultFilterType) {
+}
 
-    Parameters::addListenerToAllParameters(parameters, this);
+//==============================================================================
+// Costruttore
+FlangerAudioProcessor::FlangerAudioProcessor()
+    : parameters(*this, &undoManager, "FLG", Parameters::createParameterLayout()) {
 
     // cache raw parameter pointers per uso in processBlock (RT-safe)
-    modAmountParam = parameters.getRawParameterValue(Parameters::nameModAmount);
-    phaseDeltaParam = parameters.getRawParameterValue(Parameters::namePhaseDelta);
-    delayTimeParam = parameters.getRawParameterValue(Parameters::nameDelayTime);
-    feedbackParam = parameters.getRawParameterValue(Parameters::nameFeedback);
-    dryWetParam = parameters.getRawParameterValue(Parameters::nameDryWet);
-    filterActiveParam = parameters.getRawParameterValue(Parameters::nameFilterActive);
-    outputGainParam = parameters.getRawParameterValue(Parameters::nameOutputGain);
+    for (int i = 0; i < Parameters::numParameters; ++i)
+    {
+        parameterValues[(size_t)i] = parameters.getRawParameterValue(Parameters::allIDs[i]);
+        jassert(parameterValues[(size_t)i] != nullptr);
+    }
+
+    updateParameters(true);
 
     // init modulation buffer piccolo, sarà ridimensionato in prepareToPlay
-    modulation.setSize(getTotalNumOutputChannels(), 128);
-    modulation.clear();
+    floatChain.modulation.setSize(getTotalNumOutputChannels(), 128);
+    floatChain.modulation.clear();
 }
 
 //==============================================================================
 // Distruttore
 FlangerAudioProcessor::~FlangerAudioProcessor()
 {
-    Parameters::removeListenerFromAllParameters(parameters, this);
+    cancelPendingUpdate();
 }
 
 //==============================================================================
@@ -41,92 +51,902 @@ const juce::String FlangerAudioProcessor::getName() const { return JucePlugin_Na
 bool FlangerAudioProcessor::acceptsMidi() const { return JucePlugin_WantsMidiInput; }
 bool FlangerAudioProcessor::producesMidi() const { return JucePlugin_ProducesMidiOutput; }
 bool FlangerAudioProcessor::isMidiEffect() const { return JucePlugin_IsMidiEffect; }
-double FlangerAudioProcessor::getTailLengthSeconds() const { return 0.0; }
+// Coda: tempo perché l'eco più lungo, ricircolando col feedback, scenda sotto la soglia di silenzio.
+// Chiamata da host e messaggi: solo atomic e costanti, mai lo stato della catena (thread audio).
+// Il ritardo base della linea è limitato da DEFAULT_DELAY_TIME, come in MAX_DELAY_TIME
+double FlangerAudioProcessor::getTailLengthSeconds() const
+{
+    using namespace Parameters;
+
+    const double maxDelayMs = DEFAULT_DELAY_TIME + parameterValues[indexDelayTime]->load() + parameterValues[indexModAmount]->load();
+    const double feedbackGain = parameterValues[indexFeedback]->load();
 
-int FlangerAudioProcessor::getNumPrograms() { return 1; }
-int FlangerAudioProcessor::getCurrentProgram() { return 0; }
-void FlangerAudioProcessor::setCurrentProgram([[maybe_unused]] int index) {}
-const juce::String FlangerAudioProcessor::getProgramName([[maybe_unused]] int index) { return {}; }
-void FlangerAudioProcessor::changeProgramName([[maybe_unused]] int index, [[maybe_unused]] const juce::String& newName) {}
+    const double threshold = getSilenceThreshold();
+    const double passes = feedbackGain > 0.0 ? std::ceil(std::log(threshold) / std::log(feedbackGain)) + 1.0 : 1.0;
+
+    const double rate = getSampleRate() > 0.0 ? getSampleRate() : baseSampleRate;
+
+    return passes * maxDelayMs * 0.001 + wetLatency.load() / rate;
+}
+
+// Programmi = preset del banco (almeno uno per gli host che lo richiedono)
+int FlangerAudioProcessor::getNumPrograms()
+{
+    const juce::ScopedLock lock(presetLock);
+    return juce::jmax(1, presetBank.getNumPresets());
+}
+
+int FlangerAudioProcessor::getCurrentProgram()
+{
+    const juce::ScopedLock lock(presetLock);
+    return currentPreset;
+}
+
+void FlangerAudioProcessor::setCurrentProgram(int index) { loadPreset(index); }
+
+const juce::String FlangerAudioProcessor::getProgramName(int index)
+{
+    const juce::ScopedLock lock(presetLock);
+    if (auto* preset = presetBank.getPreset(index))
+        return preset->name;
+
+    return {};
+}
+
+void FlangerAudioProcessor::changeProgramName(int index, const juce::String& newName)
+{
+    const juce::ScopedLock lock(presetLock);
+    presetBank.renamePreset(index, newName);
+}
+
+//==============================================================================
+// Layout dei bus
+bool FlangerAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
+{
+    const auto input = layouts.getMainInputChannelSet();
+    const auto output = layouts.getMainOutputChannelSet();
+
+    // Mono -> stereo: una linea condivisa letta a due prese (Delays::prepareToPlay)
+    if (input == juce::AudioChannelSet::mono() && output == juce::AudioChannelSet::stereo())
+        return true;
+
+    return !output.isDisabled() && input == output && output.size() <= maxChannels;
+}
 
 //==============================================================================
 // Preparazione audio
 void FlangerAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    delay.prepareToPlay(sampleRate, static_cast<float>(samplesPerBlock));
-    drywetter.prepareToPlay(sampleRate, getTotalNumOutputChannels(), samplesPerBlock);
-    LFO.prepareToPlay(sampleRate);
-    timeModulation.prepareToPlay(sampleRate);
-    filter.prepareToPlay(sampleRate, getTotalNumOutputChannels());
+    baseSampleRate = sampleRate;
+
+    // Valori correnti prima del reset degli smoother: si parte senza rampe (anche un cambio di preset in corso)
+    presetHandled = presetRequests.load();
+    presetGain = 1.0f;
+    presetFadingOut = false;
+    presetGainStep = static_cast<float>(1.0 / juce::jmax(1.0, sampleRate * PRESET_FADE_MS * 0.0005));
+
+    updateParameters(true);
+
+    // Solo la catena della precisione scelta dall'host (impostata prima di prepareToPlay)
+    if (isUsingDoublePrecision())
+    {
+        releaseChain(floatChain);
+        prepareChain(doubleChain, sampleRate, samplesPerBlock);
+    }
+    else
+    {
+        releaseChain(doubleChain);
+        prepareChain(floatChain, sampleRate, samplesPerBlock);
+    }
+
+    activeOversamplingOrder = 0;
+    setOversamplingOrder(pendingOversamplingOrder);
+
+    // Fuori dal thread audio: la latenza va all'host subito
+    cancelPendingUpdate();
+    setLatencySamples(wetLatency.load());
+
+    telemetry.prepare(sampleRate, samplesPerBlock);
+    spectrumTap.prepare(sampleRate);
+
+#if FLANGER_DSP_PROFILING
+    loadMeter.prepare(sampleRate);
+#endif
+}
+
+template <typename SampleType>
+void FlangerAudioProcessor::prepareChain(DspChain<SampleType>& chain, double sampleRate, int samplesPerBlock)
+{
+    const int numChannels = getTotalNumOutputChannels();
+    const int maxFactor = 1 << maxOversamplingOrder;
+
+    // Oversampler per ogni fattore, latenza intera per poterla compensare sul dry
+    int maxLatency = 0;
+    for (int i = 0; i < maxOversamplingOrder; ++i)
+    {
+        auto& oversampler = chain.oversamplers[(size_t)i];
+        oversampler = std::make_unique<juce::dsp::Oversampling<SampleType>>(static_cast<size_t>(numChannels), static_cast<size_t>(i + 1),
+            juce::dsp::Oversampling<SampleType>::filterHalfBandPolyphaseIIR, true, true);
+        oversampler->initProcessing(static_cast<size_t>(samplesPerBlock));
+        maxLatency = juce::jmax(maxLatency, juce::roundToInt(oversampler->getLatencyInSamples()));
+    }
+
+    chain.oversampledChannels.assign(static_cast<size_t>(numChannels), nullptr);
+
+    // Buffer dimensionati per il fattore massimo: cambiare fattore non alloca
+    chain.delay.prepareToPlay(sampleRate, numChannels, samplesPerBlock * maxFactor, maxFactor, isMonoToStereo());
+    chain.drywetter.prepareToPlay(sampleRate, numChannels, samplesPerBlock, maxLatency);
+    chain.LFO.prepareToPlay(sampleRate, samplesPerBlock * maxFactor);
+    chain.timeModulation.prepareToPlay(sampleRate, samplesPerBlock * maxFactor);
+    chain.filter.prepareToPlay(sampleRate, numChannels, samplesPerBlock * maxFactor);
 
-    modulation.setSize(getTotalNumOutputChannels(), samplesPerBlock, false, false, true);
-    modulation.clear();
+    chain.modulation.setSize(numChannels * Parameters::maxVoices, samplesPerBlock * maxFactor, false, false, true);
+    chain.modulation.clear();
+    chain.filterModulation.setSize(numChannels, samplesPerBlock * maxFactor, false, false, true);
+    chain.filterModulation.clear();
 }
 
 void FlangerAudioProcessor::releaseResources()
 {
-    delay.releaseResources();
-    drywetter.releaseResources();
-    filter.reset();
-    modulation.setSize(0, 0);
+    releaseChain(floatChain);
+    releaseChain(doubleChain);
+}
+
+template <typename SampleType>
+void FlangerAudioProcessor::releaseChain(DspChain<SampleType>& chain)
+{
+    chain.delay.releaseResources();
+    chain.drywetter.releaseResources();
+    chain.filter.reset();
+    chain.modulation.setSize(0, 0);
+    chain.filterModulation.setSize(0, 0);
+
+    for (auto& oversampler : chain.oversamplers)
+        oversampler.reset();
+}
+
+void FlangerAudioProcessor::setOversamplingOrder(int newOrder)
+{
+    newOrder = juce::jlimit(0, maxOversamplingOrder, newOrder);
+    activeOversamplingOrder = newOrder;
+
+    // Tutti i moduli del percorso wet lavorano al sample rate sovracampionato
+    const double rate = baseSampleRate * (1 << newOrder);
+
+    const int latency = withActiveChain([rate, newOrder](auto& chain)
+        {
+            chain.delay.setSampleRate(rate);
+            chain.LFO.setSampleRate(rate);
+            chain.timeModulation.setSampleRate(rate);
+            chain.filter.setSampleRate(rate);
+
+            int chainLatency = 0;
+            if (newOrder > 0)
+            {
+                auto& oversampler = *chain.oversamplers[(size_t)(newOrder - 1)];
+                oversampler.reset();
+                chainLatency = juce::roundToInt(oversampler.getLatencyInSamples());
+            }
+
+            chain.drywetter.setDryDelay(chainLatency);
+            return chainLatency;
+        });
+
+    wetLatency.store(latency);
+    triggerAsyncUpdate();
+
+    // Memoria del delay azzerata: il conteggio del silenzio riparte
+    silentSamples = 0;
+    idle.store(false, std::memory_order_relaxed);
+}
+
+// Thread dei messaggi: latenza del fattore cambiato durante la riproduzione
+void FlangerAudioProcessor::handleAsyncUpdate()
+{
+    setLatencySamples(wetLatency.load());
 }
 
 //==============================================================================
 // Processamento audio
 void FlangerAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer&)
+{
+    jassert(!isUsingDoublePrecision());
+    process(buffer);
+}
+
+void FlangerAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer&)
+{
+    jassert(isUsingDoublePrecision());
+    process(buffer);
+}
+
+// Stessa catena per float e double, sui moduli della precisione del buffer
+template <typename SampleType>
+void FlangerAudioProcessor::process(juce::AudioBuffer<SampleType>& buffer)
 {
     juce::ScopedNoDenormals noDenormals;
 
     const int numSamples = buffer.getNumSamples();
+    FLANGER_LOAD_BEGIN(loadMeter, numSamples);
+
+    // Mono -> stereo: l'ingresso va su entrambi i canali (dry e telemetria), il wet lo legge solo dal canale 0.
+    // Altrimenti clear dei canali extra
+    if (isMonoToStereo())
+        buffer.copyFrom(1, 0, buffer, 0, 0, numSamples);
+    else
+        for (int ch = getTotalNumInputChannels(); ch < getTotalNumOutputChannels(); ++ch)
+            buffer.clear(ch, 0, numSamples);
+
+    telemetry.beginBlock(buffer);
+
+    if (!updatePresetSwitch<SampleType>())
+        updateParameters();
+
+    if (pendingOversamplingOrder != activeOversamplingOrder)
+        setOversamplingOrder(pendingOversamplingOrder);
+
+    const int numChannels = juce::jmin(buffer.getNumChannels(), getTotalNumInputChannels());
+    const bool inputSilent = silenceDetection.load() && isSilent(buffer, numChannels);
+
+    // L/R identici: la catena vede solo il canale sinistro (vista sul buffer, nessuna copia)
+    const bool folded = updateMonoFold(buffer);
+    juce::AudioBuffer<SampleType> chainBuffer(buffer.getArrayOfWritePointers(), folded ? 1 : buffer.getNumChannels(), numSamples);
+
+    if (idle.load(std::memory_order_relaxed))
+    {
+        if (inputSilent)
+        {
+            processIdle(chainBuffer);
+            copyFoldedChannel(buffer, folded);
+            applyPresetFade(buffer);
+            telemetry.endBlock(buffer);
+            spectrumTap.push(buffer);
+            FLANGER_LOAD_END(loadMeter);
+            return;
+        }
+
+        idle.store(false, std::memory_order_relaxed);
+    }
+
+    FLANGER_LOAD_STAGE(loadMeter, Control);
+
+    // Mix fermo tutto dry: la catena wet non è udibile.
+    // Con oversampling o con più voci si usa sempre il percorso a stadi
+    if (getChain<SampleType>().drywetter.isFullyDry())
+        processDryOnly(chainBuffer);
+    else if (processingMode.load() == ProcessingMode::fused && activeOversamplingOrder == 0 && getChain<SampleType>().delay.getNumVoices() == 1)
+        processFused(chainBuffer);
+    else
+        processStaged(chainBuffer);
+
+    updateSilenceState(chainBuffer, inputSilent);
+    copyFoldedChannel(buffer, folded);
+    applyPresetFade(buffer);
+    telemetry.endBlock(buffer);
+    spectrumTap.push(buffer);
+    FLANGER_LOAD_END(loadMeter);
+}
+
+//==============================================================================
+// Silenzio
+template <typename SampleType>
+bool FlangerAudioProcessor::isSilent(const juce::AudioBuffer<SampleType>& buffer, int numChannels)
+{
+    const auto threshold = static_cast<SampleType>(getSilenceThreshold());
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        if (buffer.getMagnitude(ch, 0, buffer.getNumSamples()) >= threshold)
+            return false;
+
+    return true;
+}
+
+template <typename SampleType>
+void FlangerAudioProcessor::updateSilenceState(const juce::AudioBuffer<SampleType>& output, bool inputSilent)
+{
+    auto& chain = getChain<SampleType>();
+
+    if (!inputSilent)
+    {
+        silentSamples = 0;
+        return;
+    }
+
+    // Campioni al rate dei moduli wet (sovracampionato)
+    silentSamples = juce::jmin(silentSamples + output.getNumSamples() * getOversamplingFactor(), std::numeric_limits<int>::max() / 2);
+
+    // Dopo un intero giro della memoria in silenzio, la memoria contiene solo il ricircolo:
+    // se anche l'uscita e la memoria sono sotto soglia la coda è esaurita
+    if (silentSamples < chain.delay.getMemorySize() || !isSilent(output, output.getNumChannels()))
+        return;
+
+    if (chain.delay.getPeakLevel() < getSilenceThreshold())
+    {
+        chain.delay.clear();
+        chain.filter.reset();
+        idle.store(true, std::memory_order_relaxed);
+    }
+}
+
+//==============================================================================
+// L/R identici
+template <typename SampleType>
+bool FlangerAudioProcessor::updateMonoFold(const juce::AudioBuffer<SampleType>& buffer)
+{
+    auto& chain = getChain<SampleType>();
+    const int numSamples = buffer.getNumSamples();
+
+    // Solo stereo -> stereo senza oversampling (lo stato degli oversampler non si può copiare),
+    // con tutti i canali alla stessa fase dell'LFO e ingressi identici bit per bit
+    const bool identical = monoDetection.load() && buffer.getNumChannels() == 2 && getTotalNumInputChannels() == 2
+        && activeOversamplingOrder == 0 && !chain.delay.isSharedLine() && chain.timeModulation.isPhaseAligned()
+        && std::memcmp(buffer.getReadPointer(0), buffer.getReadPointer(1), static_cast<size_t>(numSamples) * sizeof(SampleType)) == 0;
+
+    if (!identical)
+    {
+        // Il destro riparte dallo stato del sinistro: è quello che avrebbe avuto elaborandolo
+        if (monoFolded.load(std::memory_order_relaxed))
+        {
+            chain.delay.copyChannelState(0, 1);
+            chain.filter.copyChannelState(0, 1);
+            monoFolded.store(false, std::memory_order_relaxed);
+        }
+
+        identicalSamples = 0;
+        return false;
+    }
+
+    if (monoFolded.load(std::memory_order_relaxed))
+        return true;
+
+    identicalSamples = juce::jmin(identicalSamples + numSamples, std::numeric_limits<int>::max() / 2);
+
+    // Dopo un intero giro della memoria con ingressi identici, i due canali differiscono solo per il
+    // ricircolo di prima: sotto la soglia del silenzio il destro si allinea al sinistro.
+    // Altrimenti si riprova dopo un altro giro (il confronto costa un passaggio sulla memoria)
+    if (identicalSamples < chain.delay.getMemorySize())
+        return false;
+
+    identicalSamples = 0;
+    const auto threshold = static_cast<SampleType>(getSilenceThreshold());
+
+    if (chain.delay.getChannelDifference(0, 1) >= threshold || chain.filter.getChannelDifference(0, 1) >= threshold)
+        return false;
+
+    chain.delay.copyChannelState(0, 1);
+    chain.filter.copyChannelState(0, 1);
+    monoFolded.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+// Uscita del canale elaborato anche nel destro
+template <typename SampleType>
+void FlangerAudioProcessor::copyFoldedChannel(juce::AudioBuffer<SampleType>& buffer, bool folded)
+{
+    if (folded)
+        buffer.copyFrom(1, 0, buffer, 0, 0, buffer.getNumSamples());
+}
+
+// Processore inattivo: nessun wet, solo il dry (ritardato della latenza) e il tempo che scorre
+template <typename SampleType>
+void FlangerAudioProcessor::processIdle(juce::AudioBuffer<SampleType>& buffer)
+{
+    auto& chain = getChain<SampleType>();
+    const int wetSamples = buffer.getNumSamples() * getOversamplingFactor();
     const int numChannels = buffer.getNumChannels();
 
-    // Clear canali extra
-    for (int ch = getTotalNumInputChannels(); ch < getTotalNumOutputChannels(); ++ch)
-        buffer.clear(ch, 0, numSamples);
+    SampleType modulationMs[maxChannels * Parameters::maxVoices];
+    chain.timeModulation.getCurrentValues(chain.LFO, modulationMs, numChannels);
+    telemetry.setModulation(modulationMs, numChannels, chain.timeModulation.getNumVoices());
+
+    chain.timeModulation.skip(chain.LFO, wetSamples);
+    chain.delay.skip(wetSamples);
+    chain.filter.skip(wetSamples);
+    FLANGER_LOAD_STAGE(loadMeter, Control);
+
+    chain.drywetter.copyDrySignal(buffer);
+    buffer.clear();
+    FLANGER_LOAD_STAGE(loadMeter, DryCopy);
+
+    chain.drywetter.mixDrySignal(buffer);
+    FLANGER_LOAD_STAGE(loadMeter, Mix);
+}
+
+// Un passaggio completo sul buffer per ogni stadio
+template <typename SampleType>
+void FlangerAudioProcessor::processStaged(juce::AudioBuffer<SampleType>& buffer)
+{
+    auto& chain = getChain<SampleType>();
 
-    // Resize modulation buffer se necessario
-    if (modulation.getNumChannels() != numChannels || modulation.getNumSamples() != numSamples)
-        modulation.setSize(numChannels, numSamples, false, false, true);
-    modulation.clear();
+    // 1) copia DRY (ritardata della latenza dell'oversampling); tutto wet: solo la storia
+    const bool fullyWet = chain.drywetter.isFullyWet();
 
-    // 1) copia DRY
-    drywetter.copyDrySignal(buffer);
+    if (fullyWet)
+        chain.drywetter.pushDryHistory(buffer);
+    else
+        chain.drywetter.copyDrySignal(buffer);
 
-    // 2) calcola modulazione con LFO
-    timeModulation.process(modulation, LFO);
+    FLANGER_LOAD_STAGE(loadMeter, DryCopy);
 
-    // 3) delay/flanger
-    delay.processBlock(buffer, modulation);
+    // 2-4) percorso wet, eventualmente sovracampionato
+    if (activeOversamplingOrder == 0)
+    {
+        processWet(buffer);
+    }
+    else
+    {
+        auto oversampledBuffer = processSamplesUp(buffer);
+        FLANGER_LOAD_STAGE(loadMeter, Oversampling);
 
-    // 4) filtro opzionale
-    if (filterActiveParam && (*filterActiveParam) > 0.5f)
-        filter.processBlock(buffer);
+        processWet(oversampledBuffer);
 
-    // 5) mix dry/wet
-    drywetter.mixDrySignal(buffer);
+        juce::dsp::AudioBlock<SampleType> block(buffer);
+        chain.oversamplers[(size_t)(activeOversamplingOrder - 1)]->processSamplesDown(block);
+        FLANGER_LOAD_STAGE(loadMeter, Oversampling);
+    }
 
-    // 6) output gain
-    const float outputGainDb = (outputGainParam != nullptr) ? outputGainParam->load() : 0.0f;
-    buffer.applyGain(juce::Decibels::decibelsToGain(outputGainDb));
+    // 5) mix dry/wet + output gain (smoothed, stesso passaggio); tutto wet: solo il gain
+    if (fullyWet)
+        chain.drywetter.applyOutputGain(buffer);
+    else
+        chain.drywetter.mixDrySignal(buffer);
 
+    FLANGER_LOAD_STAGE(loadMeter, Mix);
+}
+
+// Mix tutto dry: niente interpolazione, modulazione per campione, filtro o mix. Il delay continua
+// a ricevere l'ingresso con il suo feedback (al rate sovracampionato) e LFO e smoothing avanzano,
+// così quando il mix si riapre la rampa di 20 ms del dry/wet riparte da una catena wet allineata
+template <typename SampleType>
+void FlangerAudioProcessor::processDryOnly(juce::AudioBuffer<SampleType>& buffer)
+{
+    auto& chain = getChain<SampleType>();
+    const int wetSamples = buffer.getNumSamples() * getOversamplingFactor();
+    const int numChannels = buffer.getNumChannels();
+
+    SampleType modulationMs[maxChannels * Parameters::maxVoices];
+    chain.timeModulation.getCurrentValues(chain.LFO, modulationMs, numChannels);
+    telemetry.setModulation(modulationMs, numChannels, chain.timeModulation.getNumVoices());
+
+    if (activeOversamplingOrder == 0)
+    {
+        chain.delay.pushInput(buffer, modulationMs);
+    }
+    else
+    {
+        chain.delay.pushInput(processSamplesUp(buffer), modulationMs);
+
+        // Anche il downsampling avanza (uscita scartata, nel buffer di modulazione libero): alla
+        // riapertura del mix la sua memoria non contiene l'ultimo blocco wet di prima
+        auto discarded = juce::dsp::AudioBlock<SampleType>(chain.modulation)
+            .getSubsetChannelBlock(0, static_cast<size_t>(numChannels)).getSubBlock(0, static_cast<size_t>(buffer.getNumSamples()));
+        chain.oversamplers[(size_t)(activeOversamplingOrder - 1)]->processSamplesDown(discarded);
+    }
+
+    FLANGER_LOAD_STAGE(loadMeter, Delay);
+
+    chain.timeModulation.skip(chain.LFO, wetSamples);
+    chain.filter.skip(wetSamples);
+    FLANGER_LOAD_STAGE(loadMeter, Modulation);
+
+    chain.drywetter.processDryOnly(buffer);
+    FLANGER_LOAD_STAGE(loadMeter, Mix);
+}
+
+// Buffer sovracampionato (memoria dell'oversampler attivo, nessuna allocazione)
+template <typename SampleType>
+juce::AudioBuffer<SampleType> FlangerAudioProcessor::processSamplesUp(juce::AudioBuffer<SampleType>& buffer)
+{
+    auto& chain = getChain<SampleType>();
+    auto& oversampler = *chain.oversamplers[(size_t)(activeOversamplingOrder - 1)];
+    juce::dsp::AudioBlock<SampleType> block(buffer);
+
+    auto oversampledBlock = oversampler.processSamplesUp(block);
+
+    for (size_t ch = 0; ch < oversampledBlock.getNumChannels(); ++ch)
+        chain.oversampledChannels[ch] = oversampledBlock.getChannelPointer(ch);
+
+    return juce::AudioBuffer<SampleType>(chain.oversampledChannels.data(),
+        static_cast<int>(oversampledBlock.getNumChannels()), static_cast<int>(oversampledBlock.getNumSamples()));
+}
+
+// Modulazione, delay e filtro sul buffer (al sample rate corrente dei moduli)
+template <typename SampleType>
+void FlangerAudioProcessor::processWet(juce::AudioBuffer<SampleType>& buffer)
+{
+    auto& chain = getChain<SampleType>();
+
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = buffer.getNumChannels();
+    const int numVoices = chain.delay.getNumVoices();
+
+    // Resize modulation buffer se necessario (capacità preallocata, non rialloca): un canale per voce
+    if (chain.modulation.getNumChannels() != numChannels * numVoices || chain.modulation.getNumSamples() != numSamples)
+        chain.modulation.setSize(numChannels * numVoices, numSamples, false, false, true);
+    chain.modulation.clear();
+
+    // LFO puro anche per il cutoff, solo se il filtro lo usa
+    const bool modulateFilter = filterActive && chain.filter.isModulated();
+
+    if (modulateFilter && (chain.filterModulation.getNumChannels() != numChannels || chain.filterModulation.getNumSamples() != numSamples))
+        chain.filterModulation.setSize(numChannels, numSamples, false, false, true);
+
+    auto* filterLfo = modulateFilter ? &chain.filterModulation : nullptr;
+
+    // 2-3) modulazione con LFO e delay/flanger, a audio rate o a control rate
+    const int interval = controlInterval.load();
+
+    if (interval > 1)
+    {
+        chain.timeModulation.processControlRate(chain.modulation, chain.LFO, numSamples, interval, filterLfo);
+        FLANGER_LOAD_STAGE(loadMeter, Modulation);
+
+        chain.delay.processBlock(buffer, chain.modulation, interval);
+    }
+    else
+    {
+        chain.timeModulation.process(chain.modulation, chain.LFO, filterLfo);
+        FLANGER_LOAD_STAGE(loadMeter, Modulation);
+
+        chain.delay.processBlock(buffer, chain.modulation);
+    }
+
+    FLANGER_LOAD_STAGE(loadMeter, Delay);
+
+    telemetry.captureModulation(chain.modulation, numSamples, interval, numVoices);
+
+    // 4) filtro opzionale (cutoff eventualmente modulato dall'LFO)
+    if (filterActive)
+    {
+        chain.filter.processBlock(buffer, filterLfo, interval);
+        FLANGER_LOAD_STAGE(loadMeter, Filter);
+    }
+}
+
+// Tutta la catena campione per campione in un solo loop, senza buffer intermedi.
+// Ogni smoother avanza nello stesso ordine del percorso a stadi: l'uscita coincide
+// a meno degli arrotondamenti.
+template <typename SampleType>
+void FlangerAudioProcessor::processFused(juce::AudioBuffer<SampleType>& buffer)
+{
+    auto& chain = getChain<SampleType>();
+
+    const int numSamples = buffer.getNumSamples();
+    const int numChannels = buffer.getNumChannels();
+
+    jassert(numChannels <= maxChannels);
+
+    auto channelData = buffer.getArrayOfWritePointers();
+    const bool sharedLine = chain.delay.isSharedLine();
+
+    const int interval = controlInterval.load();
+    const bool modulateFilter = filterActive && chain.filter.isModulated();
+    int segmentLength = 0, segmentPosition = 0;
+
+    // Prossimo campione da inviare all'oscilloscopio (lunghezza del blocco se nessuno)
+    int telemetryPoint = 0;
+    int telemetryPosition = telemetry.getPointPosition(0);
+
+    for (int s = 0; s < numSamples; ++s)
+    {
+        SampleType modulationMs[maxChannels], lfoValues[maxChannels];
+
+        chain.delay.beginSample();
+
+        if (filterActive)
+            chain.filter.beginSample();
+
+        if (interval > 1)
+        {
+            // Control rate: nuovo punto all'inizio di ogni segmento, poi interpolazione
+            if (segmentPosition == segmentLength)
+            {
+                segmentLength = juce::jmin(interval, numSamples - s);
+                segmentPosition = 0;
+
+                SampleType targetMs[maxChannels];
+                chain.timeModulation.processControlPoint(chain.LFO, segmentLength, targetMs, numChannels, lfoValues);
+                chain.delay.beginModulationSegment(targetMs, numChannels, segmentLength);
+
+                if (modulateFilter)
+                    for (int ch = 0; ch < numChannels; ++ch)
+                        chain.filter.setModulation(ch, lfoValues[ch]);
+            }
+
+            ++segmentPosition;
+
+            for (int ch = 0; ch < numChannels; ++ch)
+                modulationMs[ch] = chain.delay.getSegmentModulation(ch, segmentPosition);
+        }
+        else
+        {
+            chain.timeModulation.processSample(chain.LFO, modulationMs, numChannels, lfoValues);
+
+            if (modulateFilter)
+                for (int ch = 0; ch < numChannels; ++ch)
+                    chain.filter.setModulation(ch, lfoValues[ch]);
+        }
+
+        if (s == telemetryPosition)
+        {
+            telemetry.setModulation(telemetryPoint, modulationMs, numChannels);
+            telemetryPosition = telemetry.getPointPosition(++telemetryPoint);
+        }
+
+        SampleType wetGain, dryGain;
+        chain.drywetter.getNextGains(wetGain, dryGain);
+
+        // Linea condivisa: le prese di tutti i canali in una volta, dall'ingresso mono
+        SampleType taps[Delays<SampleType>::numSharedTaps];
+        if (sharedLine)
+            chain.delay.processTaps(channelData[0][s], modulationMs, taps);
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const SampleType dry = channelData[ch][s];
+            SampleType wet = sharedLine ? taps[ch] : chain.delay.processSample(ch, dry, modulationMs[ch]);
+
+            if (filterActive)
+                wet = chain.filter.processSample(ch, wet);
+
+            channelData[ch][s] = wet * wetGain + dry * dryGain;
+        }
+
+        chain.delay.advanceWriteIndex();
+    }
+
+    FLANGER_LOAD_STAGE(loadMeter, Fused);
 }
 
 //==============================================================================
 // Parametri
-void FlangerAudioProcessor::parameterChanged(const juce::String& paramID, float newValue)
+void FlangerAudioProcessor::updateParameters(bool force)
+{
+    withActiveChain([this, force](auto& chain)
+        {
+            for (int i = 0; i < Parameters::numParameters; ++i)
+            {
+                const float value = parameterValues[(size_t)i]->load(std::memory_order_relaxed);
+
+                if (force || value != appliedValues[(size_t)i])
+                {
+                    appliedValues[(size_t)i] = value;
+                    applyParameter(chain, i, value);
+                }
+            }
+
+            // Coefficienti del filtro ricalcolati al massimo una volta per blocco
+            chain.filter.updateCoefficients();
+        });
+}
+
+template <typename SampleType>
+void FlangerAudioProcessor::applyParameter(DspChain<SampleType>& chain, int index, float value)
 {
     using namespace Parameters;
+    using Waveform = typename NaiveOscillator<SampleType>::Waveform;
+
+    switch (index)
+    {
+    case indexDelayTime:     chain.timeModulation.setParameter(value); break;
+    case indexFeedback:      chain.delay.setFeedback(value); break;
+    case indexInterpolation: chain.delay.setInterpolation(juce::roundToInt(value)); break;
+    case indexDryWet:        chain.drywetter.setDryWetRatio(value); break;
+    case indexWaveform:      chain.LFO.setWaveform(static_cast<Waveform>(juce::roundToInt(value))); break;
+    case indexModFrequency:  chain.LFO.setFrequency(value); break;
+    case indexModAmount:     chain.timeModulation.setModAmount(value); break;
+    case indexPhaseDelta:    chain.timeModulation.setPhaseDelta(value); break;
+    case indexFilterActive:  filterActive = value > 0.5f; break;
+    case indexQuality:       chain.filter.setQuality(value); break;
+    case indexFilterType:    chain.filter.setFilterType(juce::roundToInt(value)); break;
+    case indexFilterCutoff:  chain.filter.setFrequency(value); break;
+    case indexFilterEngine:  chain.filter.setEngine(juce::roundToInt(value)); break;
+    case indexFilterModDepth: chain.filter.setModulationDepth(value); break;
+    case indexOutputGain:    chain.drywetter.setOutputGain(value); break;
+    case indexOversampling:  pendingOversamplingOrder = juce::roundToInt(value); break;
+    case indexVoices:
+        chain.delay.setNumVoices(1 << juce::roundToInt(value));
+        chain.timeModulation.setNumVoices(chain.delay.getNumVoices());
+        break;
+    default:                 jassertfalse; break;
+    }
+}
+
+//==============================================================================
+// Preset
+int FlangerAudioProcessor::storePreset(const juce::String& name)
+{
+    int index;
+    {
+        const juce::ScopedLock lock(presetLock);
+        index = presetBank.addPreset(name, captureValues());
+
+        if (index >= 0)
+            currentPreset = index;
+    }
+
+    if (index >= 0)
+        updateHostDisplay();
 
-    if (paramID == nameDelayTime)     timeModulation.setParameter(newValue);
-    else if (paramID == nameFeedback)      delay.setFeedback(newValue);
-    else if (paramID == nameDryWet)        drywetter.setDryWetRatio(newValue);
-    else if (paramID == nameWaveform)      LFO.setWaveform(static_cast<NaiveOscillator::Waveform>(juce::roundToInt(newValue)));
-    else if (paramID == nameModFrequency)  LFO.setFrequency(newValue);
-    else if (paramID == nameModAmount)     timeModulation.setModAmount(newValue);
-    else if (paramID == namePhaseDelta)    timeModulation.setPhaseDelta(newValue);
-    else if (paramID == nameFilterType)    filter.setFilterType(juce::roundToInt(newValue));
-    else if (paramID == nameFilterCutoff)  filter.setFrequency(newValue);
-    else if (paramID == nameQuality)       filter.setQuality(newValue);
+    return index;
+}
+
+void FlangerAudioProcessor::storePreset(int index, const juce::String& name)
+{
+    {
+        const juce::ScopedLock lock(presetLock);
+        presetBank.setPreset(index, name, captureValues());
+    }
+
+    updateHostDisplay();
+}
+
+bool FlangerAudioProcessor::loadPreset(int index)
+{
+    Presets::Values values;
+    {
+        const juce::ScopedLock lock(presetLock);
+        auto* preset = presetBank.getPreset(index);
+
+        if (preset == nullptr)
+            return false;
+
+        values = preset->values;
+        currentPreset = index;
+    }
+
+    requestValues(values);
+    return true;
+}
+
+void FlangerAudioProcessor::requestValues(const Presets::Values& values)
+{
+    // Valori quantizzati e limitati come li vedrà updateParameters dagli atomic
+    Presets::Values quantised = values;
+
+    for (int i = 0; i < Parameters::numParameters; ++i)
+        if (auto* param = parameters.getParameter(Parameters::allIDs[i]))
+            quantised[(size_t)i] = param->convertFrom0to1(param->convertTo0to1(values[(size_t)i]));
+
+    // Fino alla fine delle notifiche gli atomic sono ancora quelli vecchi: il thread audio non li legge
+    pendingNotifications.fetch_add(1);
+
+    // Mai dal thread audio: sequenza e pubblicazione sotto lo stesso lock, da qui il thread audio
+    // sfuma l'uscita e applica lo snapshot con questa sequenza
+    {
+        const juce::ScopedLock lock(requestLock);
+
+        auto& snapshot = presetSnapshots.getWriteBuffer();
+        snapshot.values = quantised;
+        snapshot.sequence = presetRequests.fetch_add(1) + 1;
+        presetSnapshots.publish();
+    }
+
+    // Notifiche fuori dal lock: l'host può richiamare il processore (automazione, altri stati)
+    for (int i = 0; i < Parameters::numParameters; ++i)
+        if (auto* param = parameters.getParameter(Parameters::allIDs[i]))
+        {
+            const float normalised = param->convertTo0to1(values[(size_t)i]);
+
+            if (normalised != param->getValue())
+                param->setValueNotifyingHost(normalised);
+        }
+
+    pendingNotifications.fetch_sub(1);
+}
+
+Presets::Values FlangerAudioProcessor::captureValues() const noexcept
+{
+    Presets::Values values;
+
+    for (int i = 0; i < Parameters::numParameters; ++i)
+        values[(size_t)i] = parameterValues[(size_t)i]->load();
+
+    return values;
+}
+
+Presets::Values FlangerAudioProcessor::getDefaultValues() const
+{
+    Presets::Values values;
+
+    for (int i = 0; i < Parameters::numParameters; ++i)
+    {
+        auto* param = parameters.getParameter(Parameters::allIDs[i]);
+        values[(size_t)i] = param->convertFrom0to1(param->getDefaultValue());
+    }
+
+    return values;
+}
+
+template <typename SampleType>
+bool FlangerAudioProcessor::updatePresetSwitch()
+{
+    const juce::uint32 requested = presetRequests.load();
+
+    // Preset applicato, ma gli atomic arrivano solo con le notifiche all'host: parametri congelati
+    if (requested == presetHandled)
+        return pendingNotifications.load() > 0;
+
+    // Si sfuma con i valori correnti; lo snapshot si applica solo a uscita muta
+    presetFadingOut = true;
+
+    if (presetGain > 0.0f)
+        return true;
+
+    presetSnapshots.acquire();
+    const auto& snapshot = presetSnapshots.getReadBuffer();
+
+    // Snapshot non ancora pubblicato (o superato da una richiesta successiva): si resta muti
+    if (snapshot.sequence != requested)
+        return true;
+
+    applyPresetSnapshot(getChain<SampleType>(), snapshot.values);
+    presetHandled = requested;
+    presetFadingOut = false;
+    return true;
+}
+
+template <typename SampleType>
+void FlangerAudioProcessor::applyPresetSnapshot(DspChain<SampleType>& chain, const Presets::Values& values)
+{
+    for (int i = 0; i < Parameters::numParameters; ++i)
+        if (values[(size_t)i] != appliedValues[(size_t)i])
+        {
+            appliedValues[(size_t)i] = values[(size_t)i];
+            applyParameter(chain, i, values[(size_t)i]);
+        }
+
+    // A uscita muta le rampe non servono: tutti i valori saltano al preset
+    chain.delay.snapToTargets();
+    chain.drywetter.snapToTargets();
+    chain.LFO.snapToTargets();
+    chain.timeModulation.snapToTargets();
+    chain.filter.snapToTargets();
+
+    // Un solo ricalcolo dei coefficienti per tutto il preset
+    chain.filter.updateCoefficients();
+}
+
+// Rampa lineare del guadagno di uscita verso 0 (cambio in corso) o verso 1
+template <typename SampleType>
+void FlangerAudioProcessor::applyPresetFade(juce::AudioBuffer<SampleType>& buffer) noexcept
+{
+    const float target = presetFadingOut ? 0.0f : 1.0f;
+
+    if (presetGain == target)
+        return;
+
+    const int numSamples = buffer.getNumSamples();
+    const float distance = std::abs(target - presetGain);
+    const float blockDistance = presetGainStep * static_cast<float>(numSamples);
+
+    // Fine della rampa nel blocco, o valore raggiunto all'ultimo campione
+    const bool reachesTarget = distance <= blockDistance;
+    const float endGain = reachesTarget ? target : presetGain + (target > presetGain ? blockDistance : -blockDistance);
+    const int rampLength = reachesTarget ? juce::jlimit(0, numSamples, static_cast<int>(std::ceil(distance / presetGainStep))) : numSamples;
+
+    buffer.applyGainRamp(0, rampLength, static_cast<SampleType>(presetGain), static_cast<SampleType>(endGain));
+
+    if (endGain == 0.0f)
+        buffer.clear(rampLength, numSamples - rampLength);
+
+    presetGain = endGain;
+}
+
+size_t FlangerAudioProcessor::getMemoryFootprint() const noexcept
+{
+    // La catena non preparata non occupa memoria
+    auto chainFootprint = [](const auto& chain)
+        {
+            const size_t sampleBytes = sizeof(*chain.modulation.getReadPointer(0));
+
+            const auto modulationBytes = (static_cast<size_t>(chain.modulation.getNumChannels()) * static_cast<size_t>(chain.modulation.getNumSamples())
+                + static_cast<size_t>(chain.filterModulation.getNumChannels()) * static_cast<size_t>(chain.filterModulation.getNumSamples())) * sampleBytes;
+
+            return chain.delay.getMemoryFootprint() + chain.drywetter.getMemoryFootprint() + modulationBytes;
+        };
+
+    return chainFootprint(floatChain) + chainFootprint(doubleChain);
 }
 
 //==============================================================================
@@ -139,18 +959,40 @@ juce::AudioProcessorEditor* FlangerAudioProcessor::createEditor()
 
 //==============================================================================
 // Stato
+// Formato binario compatto (Presets.h): valori reali e banco di preset, senza passare dall'XML
 void FlangerAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
-    auto state = parameters.copyState();
-    if (auto xml = state.createXml())
-        copyXmlToBinary(*xml, destData);
+    juce::MemoryOutputStream out(destData, false);
+
+    const juce::ScopedLock lock(presetLock);
+    Presets::writeState(out, captureValues(), presetBank);
 }
 
+// Stato binario o XML delle versioni precedenti. I parametri sono impostati come un cambio
+// di preset: notificano solo quelli cambiati e il thread audio applica tutto in un blocco
 void FlangerAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    if (auto xmlState = getXmlFromBinary(data, sizeInBytes))
-        if (xmlState->hasTagName(parameters.state.getType()))
-            parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
+    auto values = getDefaultValues();
+    Presets::PresetBank bank;
+
+    if (Presets::readState(data, sizeInBytes, values, bank))
+    {
+        const juce::ScopedLock lock(presetLock);
+        presetBank = std::move(bank);
+        currentPreset = 0;
+    }
+    else
+    {
+        auto xmlState = getXmlFromBinary(data, sizeInBytes);
+        if (xmlState == nullptr || !xmlState->hasTagName(parameters.state.getType()))
+            return;
+
+        values = getDefaultValues();
+        Presets::readXmlValues(*xmlState, values);
+    }
+
+    requestValues(values);
+    updateHostDisplay();
 }
 
 //==============================================================================
@@ -6,11 +6,26 @@
 #include "Delays.h"
 #include "DryWet.h"
 #include "Filters.h"
+#include "LoadMeter.h"
+#include "Telemetry.h"
+#include "Presets.h"
+#include "TripleBuffer.h"
+
+// Intervallo di default della modulazione a control rate (1 = audio rate)
+#ifndef DEFAULT_CONTROL_INTERVAL
+#define DEFAULT_CONTROL_INTERVAL 1
+#endif
+
+// Soglia di silenzio (dBFS): ingresso e memoria del delay sotto soglia = processore inattivo.
+// Usata anche per stimare la coda riportata all'host
+#ifndef SILENCE_THRESHOLD_DB
+#define SILENCE_THRESHOLD_DB -100.0f
+#endif
 
 //==============================================================================
 class FlangerAudioProcessor : public juce::AudioProcessor,
-    public juce::AudioProcessorValueTreeState::Listener,
-    public juce::UndoManager
+    public juce::UndoManager,
+    private juce::AsyncUpdater
 {
 public:
     //==============================================================================
@@ -22,6 +37,18 @@ public:
     void releaseResources() override;
 
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+
+    // Stesso layout in ingresso e in uscita, da mono fino a maxChannels canali (5.1, 7.1.4...),
+    // oppure mono -> stereo. Ogni canale ha il suo delay; l'LFO di ogni canale è sfasato di
+    // Phase Delta dal precedente. In mono -> stereo i due canali leggono una sola linea
+    static constexpr int maxChannels = 16;
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+    bool isMonoToStereo() const { return getTotalNumInputChannels() == 1 && getTotalNumOutputChannels() == 2; }
+
+    // Catena completa anche in double (host a 64 bit): moduli e buffer separati da quelli float,
+    // si prepara solo quella della precisione scelta dall'host
+    bool supportsDoublePrecisionProcessing() const override { return true; }
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -47,31 +74,207 @@ public:
     void setStateInformation(const void* data, int sizeInBytes) override;
 
     //==============================================================================
-    void parameterChanged(const juce::String& paramID, float newValue) override;
+    // Motore di processing: a stadi (un passaggio per stadio) o fuso (un solo loop per campione).
+    // Si può cambiare in qualsiasi momento, lo stato dei moduli è condiviso.
+    enum class ProcessingMode { staged, fused };
+
+    void setProcessingMode(ProcessingMode newMode) noexcept { processingMode.store(newMode); }
+    ProcessingMode getProcessingMode() const noexcept { return processingMode.load(); }
+
+    // Modulazione a control rate: LFO e smoothing del delay time valutati ogni N campioni,
+    // traiettoria del delay interpolata linearmente tra i punti (1 = audio rate)
+    static constexpr int maxControlInterval = 64;
+
+    void setControlInterval(int newInterval) noexcept { controlInterval.store(juce::jlimit(1, maxControlInterval, newInterval)); }
+    int getControlInterval() const noexcept { return controlInterval.load(); }
+
+    // Oversampling attorno a modulazione, delay e filtro: fattore 2^order (parametro "oversampling")
+    static constexpr int maxOversamplingOrder = 3;
+
+    int getOversamplingFactor() const noexcept { return 1 << activeOversamplingOrder; }
+
+    // Ingresso silenzioso e coda esaurita: modulazione, delay e filtro non vengono elaborati
+    // (la fase dell'LFO continua ad avanzare). Attivo di default
+    void setSilenceDetection(bool shouldDetect) noexcept { silenceDetection.store(shouldDetect); }
+    bool isIdle() const noexcept { return idle.load(std::memory_order_relaxed); }
+
+    // Ingresso stereo con L e R identici e Phase Delta a zero: la catena elabora solo il sinistro
+    // e lo copia nel destro. Il destro riprende lo stato del sinistro appena i canali divergono. Attivo di default
+    void setMonoDetection(bool shouldDetect) noexcept { monoDetection.store(shouldDetect); }
+    bool isMonoFolded() const noexcept { return monoFolded.load(std::memory_order_relaxed); }
+
+    // Memoria audio allocata dall'istanza (buffer di delay, dry e modulazione), in byte
+    size_t getMemoryFootprint() const noexcept;
+
+    // Punti decimati di ingresso, uscita e modulazione per l'oscilloscopio dell'editor
+    TelemetryTap& getTelemetry() noexcept { return telemetry; }
+
+    // Uscita a piena risoluzione per l'analizzatore di spettro (FFT sul thread di analisi dell'editor)
+    SpectrumTap& getSpectrumTap() noexcept { return spectrumTap; }
+
+    // Banco di preset in memoria (salvato nello stato, esposto all'host come programmi).
+    // Il cambio di preset sul thread audio: dissolvenza in uscita con i valori correnti, snapshot
+    // applicato in un colpo solo (coefficienti ricalcolati una volta, niente rampe), dissolvenza in entrata.
+    // Nuovo preset dai valori correnti: indice, -1 se il banco è pieno
+    int storePreset(const juce::String& name);
+    void storePreset(int index, const juce::String& name);
+    bool loadPreset(int index);
+
+    // Solo thread dei messaggi
+    const Presets::PresetBank& getPresetBank() const noexcept { return presetBank; }
+
+#if FLANGER_DSP_PROFILING
+    // Carico DSP per blocco e per stadio, letto dall'editor senza lock
+    const DspLoadMeter& getLoadMeter() const noexcept { return loadMeter; }
+    void resetLoadStatistics() noexcept { loadMeter.resetStatistics(); }
+#endif
 
 private:
+    //==============================================================================
+    // Moduli audio e buffer di una precisione (float o double)
+    template <typename SampleType>
+    struct DspChain
+    {
+        DspChain();
+
+        Delays<SampleType> delay;
+        DryWet<SampleType> drywetter;
+        NaiveOscillator<SampleType> LFO;
+        ParameterModulation<SampleType> timeModulation;
+        StereoFilter<SampleType> filter;
+
+        // Buffer per modulazione o punti di controllo (solo percorso a stadi)
+        juce::AudioBuffer<SampleType> modulation;
+        juce::AudioBuffer<SampleType> filterModulation;    // LFO puro per il cutoff del filtro
+
+        // Oversampler polifase IIR 2x/4x/8x, creati in prepareToPlay
+        std::array<std::unique_ptr<juce::dsp::Oversampling<SampleType>>, maxOversamplingOrder> oversamplers;
+        std::vector<SampleType*> oversampledChannels;
+    };
+
+    template <typename SampleType>
+    DspChain<SampleType>& getChain() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleChain;
+        else
+            return floatChain;
+    }
+
+    // Chiama function con la catena della precisione corrente
+    template <typename Function>
+    decltype(auto) withActiveChain(Function&& function)
+    {
+        return isUsingDoublePrecision() ? function(doubleChain) : function(floatChain);
+    }
+
+    template <typename Function>
+    decltype(auto) withActiveChain(Function&& function) const
+    {
+        return isUsingDoublePrecision() ? function(doubleChain) : function(floatChain);
+    }
+
+    template <typename SampleType> void prepareChain(DspChain<SampleType>& chain, double sampleRate, int samplesPerBlock);
+    template <typename SampleType> void releaseChain(DspChain<SampleType>& chain);
+    template <typename SampleType> void process(juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType> void processStaged(juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType> void processWet(juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType> void processFused(juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType> void processIdle(juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType> void processDryOnly(juce::AudioBuffer<SampleType>& buffer);
+
+    // Upsampling con l'oversampler attivo: il buffer restituito punta alla sua memoria
+    template <typename SampleType> juce::AudioBuffer<SampleType> processSamplesUp(juce::AudioBuffer<SampleType>& buffer);
+
+    // Aggiorna il conteggio del silenzio dopo un blocco elaborato, entra in idle a coda esaurita
+    template <typename SampleType> void updateSilenceState(const juce::AudioBuffer<SampleType>& output, bool inputSilent);
+    template <typename SampleType> static bool isSilent(const juce::AudioBuffer<SampleType>& buffer, int numChannels);
+
+    // Decide a inizio blocco se elaborare un canale solo (L/R identici), true se sì
+    template <typename SampleType> bool updateMonoFold(const juce::AudioBuffer<SampleType>& buffer);
+    template <typename SampleType> static void copyFoldedChannel(juce::AudioBuffer<SampleType>& buffer, bool folded);
+
+    // Applica un nuovo fattore di oversampling senza allocare (thread audio). La latenza nuova
+    // arriva all'host dal thread dei messaggi (handleAsyncUpdate): setLatencySamples notifica l'host
+    void setOversamplingOrder(int newOrder);
+    void handleAsyncUpdate() override;
+
+    // Legge i valori dei parametri (atomic dell'APVTS) e applica quelli cambiati alla catena
+    // attiva. Chiamata dal thread audio a inizio blocco: nessun lock, nessuna allocazione
+    void updateParameters(bool force = false);
+    template <typename SampleType> void applyParameter(DspChain<SampleType>& chain, int index, float value);
+
+    // Preset: snapshot dei valori reali dei parametri, con la sequenza della richiesta che lo ha prodotto
+    struct PresetSnapshot
+    {
+        Presets::Values values{};
+        juce::uint32 sequence = 0;
+    };
+
+    // Pubblica lo snapshot per il thread audio, poi imposta i parametri (solo quelli cambiati notificano l'host)
+    void requestValues(const Presets::Values& values);
+    Presets::Values captureValues() const noexcept;
+    Presets::Values getDefaultValues() const;
+
+    // Thread audio: true se un cambio di preset è in corso (i parametri restano congelati)
+    template <typename SampleType> bool updatePresetSwitch();
+    template <typename SampleType> void applyPresetSnapshot(DspChain<SampleType>& chain, const Presets::Values& values);
+    template <typename SampleType> void applyPresetFade(juce::AudioBuffer<SampleType>& buffer) noexcept;
+
     //==============================================================================
     juce::AudioProcessorValueTreeState parameters;
     juce::UndoManager undoManager;
 
     // Audio modules
-    Delays delay;
-    DryWet drywetter;
-    NaiveOscillator LFO;
-    ParameterModulation timeModulation;
-    StereoFilter filter;
-
-    // Buffer per modulazione
-    juce::AudioBuffer<float> modulation;
-
-    // Caching dei parametri (RT-safe)
-    std::atomic<float>* modAmountParam{ nullptr };
-    std::atomic<float>* phaseDeltaParam{ nullptr };
-    std::atomic<float>* delayTimeParam{ nullptr };
-    std::atomic<float>* feedbackParam{ nullptr };
-    std::atomic<float>* dryWetParam{ nullptr };
-    std::atomic<float>* filterActiveParam{ nullptr };
-    std::atomic<float>* outputGainParam{ nullptr };
+    DspChain<float> floatChain;
+    DspChain<double> doubleChain;
+
+    int activeOversamplingOrder{ 0 };
+    std::atomic<int> wetLatency{ 0 };       // latenza dell'oversampling attivo, anche prima che l'host la riceva
+    double baseSampleRate{ 44100.0 };
+
+    std::atomic<ProcessingMode> processingMode{ ProcessingMode::staged };
+    std::atomic<int> controlInterval{ DEFAULT_CONTROL_INTERVAL };
+    std::atomic<bool> silenceDetection{ true };
+
+    // Silenzio: campioni consecutivi di ingresso sotto soglia, processore inattivo
+    // (scritto solo dal thread audio, atomic per isIdle dagli altri thread)
+    int silentSamples{ 0 };
+    std::atomic<bool> idle{ false };
+
+    // L/R identici: campioni consecutivi con ingressi uguali, catena ridotta al canale sinistro
+    // (monoFolded scritto solo dal thread audio, atomic per isMonoFolded)
+    std::atomic<bool> monoDetection{ true };
+    int identicalSamples{ 0 };
+    std::atomic<bool> monoFolded{ false };
+
+    // Parametri: puntatori agli atomic dell'APVTS e ultimo valore applicato, per indice
+    std::array<std::atomic<float>*, Parameters::numParameters> parameterValues{};
+    std::array<float, Parameters::numParameters> appliedValues{};
+    bool filterActive{ Parameters::defaultFilterActive };
+    int pendingOversamplingOrder{ Parameters::defaultOversampling };
+
+    TelemetryTap telemetry;
+    SpectrumTap spectrumTap;
+
+    // Preset: il banco è protetto da presetLock (messaggi/host), il thread audio vede solo gli snapshot
+    Presets::PresetBank presetBank;
+    int currentPreset{ 0 };
+    juce::CriticalSection presetLock;
+
+    // Richieste da più thread (host e messaggi): requestLock serializza sequenza e pubblicazione, così
+    // l'ultimo snapshot pubblicato porta sempre la sequenza più alta (il TripleBuffer ha un solo scrittore)
+    juce::CriticalSection requestLock;
+    TripleBuffer<PresetSnapshot> presetSnapshots;
+    std::atomic<juce::uint32> presetRequests{ 0 };
+    std::atomic<int> pendingNotifications{ 0 };         // richieste che stanno ancora notificando l'host
+    juce::uint32 presetHandled{ 0 };                    // solo thread audio
+    float presetGain{ 1.0f }, presetGainStep{ 1.0f };
+    bool presetFadingOut{ false };
+
+#if FLANGER_DSP_PROFILING
+    DspLoadMeter loadMeter;
+#endif
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FlangerAudioProcessor)
@@ -0,0 +1,214 @@
+#pragma once
+#include <JuceHeader.h>
+#include "PluginParameters.h"
+
+// Durata totale del cambio di preset sul thread audio (dissolvenza in uscita + in entrata), ms
+#ifndef PRESET_FADE_MS
+#define PRESET_FADE_MS 10.0
+#endif
+
+namespace Presets
+{
+    // Valori reali dei parametri, nell'ordine di Parameters::allIDs
+    using Values = std::array<float, Parameters::numParameters>;
+
+    //==============================================================
+    //                       Formato binario dello stato
+    //==============================================================
+    // "FFst" | versione (uint16) | valori | banco di preset
+    // valori: numero (uint16), poi per ciascuno hash FNV-1a dell'ID (uint32) e valore (float)
+    // banco:  numero di preset (uint16), poi per ciascuno nome (UTF-8, terminato da 0) e valori
+    // Little-endian (MemoryOutputStream). Ogni valore porta l'hash del suo ID: gli ID sconosciuti
+    // (versioni successive) sono ignorati, quelli assenti (versioni precedenti) restano al default.
+    static constexpr juce::uint32 stateMagic = 0x74734646;     // "FFst"
+    static constexpr int stateVersion = 1;
+
+    constexpr juce::uint32 hashID(const char* id) noexcept
+    {
+        juce::uint32 hash = 2166136261u;
+        for (; *id != 0; ++id)
+            hash = (hash ^ static_cast<juce::uint8>(*id)) * 16777619u;
+        return hash;
+    }
+
+    inline const std::array<juce::uint32, Parameters::numParameters>& getIDHashes() noexcept
+    {
+        static const auto hashes = []
+            {
+                std::array<juce::uint32, Parameters::numParameters> result{};
+                for (int i = 0; i < Parameters::numParameters; ++i)
+                    result[(size_t)i] = hashID(Parameters::allIDs[i]);
+                return result;
+            }();
+
+        return hashes;
+    }
+
+    inline void writeValues(juce::OutputStream& out, const Values& values)
+    {
+        const auto& hashes = getIDHashes();
+        out.writeShort(static_cast<short>(Parameters::numParameters));
+
+        for (int i = 0; i < Parameters::numParameters; ++i)
+        {
+            out.writeInt(static_cast<int>(hashes[(size_t)i]));
+            out.writeFloat(values[(size_t)i]);
+        }
+    }
+
+    // values contiene già i default; false se i dati sono troncati
+    inline bool readValues(juce::InputStream& in, Values& values)
+    {
+        const auto& hashes = getIDHashes();
+
+        if (in.getNumBytesRemaining() < 2)
+            return false;
+
+        const int count = static_cast<juce::uint16>(in.readShort());
+
+        for (int n = 0; n < count; ++n)
+        {
+            if (in.getNumBytesRemaining() < 8)
+                return false;
+
+            const auto hash = static_cast<juce::uint32>(in.readInt());
+            const float value = in.readFloat();
+
+            const auto found = std::find(hashes.begin(), hashes.end(), hash);
+            if (found != hashes.end() && std::isfinite(value))
+                values[(size_t)(found - hashes.begin())] = value;
+        }
+
+        return true;
+    }
+
+    //==============================================================
+    //                       PresetBank
+    //==============================================================
+    // Preset in memoria, solo lato messaggi/host: il thread audio riceve i valori come snapshot
+    // (FlangerAudioProcessor::loadPreset) e non legge mai il banco
+    struct Preset
+    {
+        juce::String name;
+        Values values{};
+    };
+
+    class PresetBank
+    {
+    public:
+        static constexpr int maxPresets = 128;
+
+        int getNumPresets() const noexcept { return static_cast<int>(presets.size()); }
+
+        const Preset* getPreset(int index) const noexcept
+        {
+            return juce::isPositiveAndBelow(index, getNumPresets()) ? &presets[(size_t)index] : nullptr;
+        }
+
+        // Indice del nuovo preset, -1 se il banco è pieno
+        int addPreset(const juce::String& name, const Values& values)
+        {
+            if (getNumPresets() >= maxPresets)
+                return -1;
+
+            presets.push_back({ name, values });
+            return getNumPresets() - 1;
+        }
+
+        void setPreset(int index, const juce::String& name, const Values& values)
+        {
+            if (juce::isPositiveAndBelow(index, getNumPresets()))
+                presets[(size_t)index] = { name, values };
+        }
+
+        void renamePreset(int index, const juce::String& name)
+        {
+            if (juce::isPositiveAndBelow(index, getNumPresets()))
+                presets[(size_t)index].name = name;
+        }
+
+        void removePreset(int index)
+        {
+            if (juce::isPositiveAndBelow(index, getNumPresets()))
+                presets.erase(presets.begin() + index);
+        }
+
+        void clear() { presets.clear(); }
+
+        void write(juce::OutputStream& out) const
+        {
+            out.writeShort(static_cast<short>(getNumPresets()));
+
+            for (const auto& preset : presets)
+            {
+                out.writeString(preset.name);
+                writeValues(out, preset.values);
+            }
+        }
+
+        // I parametri assenti in un preset prendono i default
+        bool read(juce::InputStream& in, const Values& defaults)
+        {
+            presets.clear();
+
+            if (in.isExhausted())
+                return true;
+
+            const int count = juce::jmin(static_cast<int>(static_cast<juce::uint16>(in.readShort())), maxPresets);
+
+            for (int n = 0; n < count; ++n)
+            {
+                Preset preset{ in.readString(), defaults };
+                if (!readValues(in, preset.values))
+                    return false;
+
+                presets.push_back(std::move(preset));
+            }
+
+            return true;
+        }
+
+    private:
+        std::vector<Preset> presets;
+    };
+
+    //==============================================================
+    //                       Stato completo
+    //==============================================================
+    inline void writeState(juce::OutputStream& out, const Values& values, const PresetBank& bank)
+    {
+        out.writeInt(static_cast<int>(stateMagic));
+        out.writeShort(static_cast<short>(stateVersion));
+        writeValues(out, values);
+        bank.write(out);
+    }
+
+    // false se i dati non sono nel formato binario (blob XML delle versioni precedenti), sono troncati
+    // o vengono da una versione del formato successiva a questa. values contiene già i default
+    inline bool readState(const void* data, int sizeInBytes, Values& values, PresetBank& bank)
+    {
+        juce::MemoryInputStream in(data, static_cast<size_t>(juce::jmax(0, sizeInBytes)), false);
+
+        if (sizeInBytes < 8 || static_cast<juce::uint32>(in.readInt()) != stateMagic)
+            return false;
+
+        const int version = static_cast<juce::uint16>(in.readShort());
+
+        // Layout sconosciuto: meglio i default che valori letti male
+        if (version < 1 || version > stateVersion)
+            return false;
+
+        // Versione 1: valori, poi banco. Un nuovo layout aggiunge qui il suo ramo
+        const Values defaults = values;
+        return readValues(in, values) && bank.read(in, defaults);
+    }
+
+    // Valori dall'XML dell'AudioProcessorValueTreeState (<FLG><PARAM id=".." value=".."/>...</FLG>)
+    inline void readXmlValues(const juce::XmlElement& xml, Values& values)
+    {
+        for (auto* param : xml.getChildWithTagNameIterator("PARAM"))
+            for (int i = 0; i < Parameters::numParameters; ++i)
+                if (param->getStringAttribute("id") == Parameters::allIDs[i])
+                    values[(size_t)i] = static_cast<float>(param->getDoubleAttribute("value", values[(size_t)i]));
+    }
+}
@@ -0,0 +1,110 @@
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================
+//                       SmoothedBlock
+//==============================================================
+// Valori di un parametro per un blocco: costante (nessun buffer) o rampa campione per campione.
+// visit() chiama il kernel con l'accessore adatto, così la scelta costante/rampa è fatta
+// una volta per blocco e ogni variante è un loop specializzato, senza branch per campione.
+template <typename SampleType>
+struct SmoothedBlock
+{
+    const SampleType* ramp = nullptr;   // nullptr: valore costante
+    SampleType value = 0;               // valore costante, o ultimo valore della rampa
+
+    bool isConstant() const noexcept { return ramp == nullptr; }
+
+    struct Constant
+    {
+        SampleType value;
+        inline SampleType operator[](int) const noexcept { return value; }
+    };
+
+    struct Ramp
+    {
+        const SampleType* data;
+        inline SampleType operator[](int index) const noexcept { return data[index]; }
+    };
+
+    template <typename Function>
+    void visit(Function&& kernel) const
+    {
+        if (ramp == nullptr)
+            kernel(Constant{ value });
+        else
+            kernel(Ramp{ ramp });
+    }
+};
+
+// Due parametri insieme: quattro varianti del kernel (costante/rampa per ciascuno)
+template <typename SampleType, typename Function>
+void visitSmoothedBlocks(const SmoothedBlock<SampleType>& first, const SmoothedBlock<SampleType>& second, Function&& kernel)
+{
+    first.visit([&](auto firstValues)
+        {
+            second.visit([&](auto secondValues) { kernel(firstValues, secondValues); });
+        });
+}
+
+//==============================================================
+//                       BlockSmoothedValue
+//==============================================================
+// SmoothedValue di JUCE valutato a blocchi: process(n) avanza lo smoothing di n campioni
+// una sola volta per blocco (indipendentemente dal numero di canali) e restituisce il valore
+// costante o la rampa scritta nel buffer interno. Il percorso per-campione (motore fuso)
+// usa getNextValue() come prima; le due strade danno gli stessi valori.
+template <typename SampleType, typename SmoothingType = juce::ValueSmoothingTypes::Linear>
+class BlockSmoothedValue
+{
+public:
+    BlockSmoothedValue() = default;
+
+    // Unico punto in cui si alloca (fuori dal thread audio)
+    void setMaximumBlockSize(int maxNumSamples)
+    {
+        capacity = juce::jmax(1, maxNumSamples);
+        rampBuffer.allocate(static_cast<size_t>(capacity), true);
+    }
+
+    // Nuovo sample rate o durata della rampa, senza allocare: il valore salta al target
+    void reset(double sampleRate, double rampLengthInSeconds) noexcept
+    {
+        smoother.reset(sampleRate, rampLengthInSeconds);
+    }
+
+    void setTargetValue(SampleType newValue) noexcept { smoother.setTargetValue(newValue); }
+    void setCurrentAndTargetValue(SampleType newValue) noexcept { smoother.setCurrentAndTargetValue(newValue); }
+
+    // Termina la rampa in corso: il valore salta al target
+    void snapToTarget() noexcept { smoother.setCurrentAndTargetValue(smoother.getTargetValue()); }
+
+    bool isSmoothing() const noexcept { return smoother.isSmoothing(); }
+    SampleType getCurrentValue() const noexcept { return smoother.getCurrentValue(); }
+    SampleType getTargetValue() const noexcept { return smoother.getTargetValue(); }
+
+    // Percorso per-campione
+    inline SampleType getNextValue() noexcept { return smoother.getNextValue(); }
+    SampleType skip(int numSamples) noexcept { return smoother.skip(numSamples); }
+
+    // Valori dei prossimi numSamples campioni
+    SmoothedBlock<SampleType> process(int numSamples) noexcept
+    {
+        if (!smoother.isSmoothing())
+            return { nullptr, smoother.getTargetValue() };
+
+        jassert(numSamples <= capacity);
+        numSamples = juce::jmin(numSamples, capacity);
+
+        SampleType* ramp = rampBuffer.get();
+        for (int s = 0; s < numSamples; ++s)
+            ramp[s] = smoother.getNextValue();
+
+        return { ramp, smoother.getCurrentValue() };
+    }
+
+private:
+    juce::SmoothedValue<SampleType, SmoothingType> smoother;
+    juce::HeapBlock<SampleType> rampBuffer;
+    int capacity = 0;
+};
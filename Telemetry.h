@@ -0,0 +1,286 @@
+#pragma once
+#include <JuceHeader.h>
+
+// Punti al secondo inviati all'editor (decimazione fatta sul thread audio)
+#ifndef TELEMETRY_POINT_RATE
+#define TELEMETRY_POINT_RATE 2000.0
+#endif
+
+// Capacità della FIFO in punti: con l'editor fermo i punti in eccesso vengono scartati
+#ifndef TELEMETRY_FIFO_SIZE
+#define TELEMETRY_FIFO_SIZE 8192
+#endif
+
+//==============================================================
+//                       TelemetryTap
+//==============================================================
+// Presa di segnale dal thread audio verso l'editor: un punto ogni "decimation" campioni con
+// ingresso, uscita, picchi dall'ultimo punto e delay modulato (traiettoria dell'LFO, ms).
+// Un solo scrittore (processBlock) e un solo lettore (editor) su una AbstractFifo:
+// nessun lock, nessuna allocazione dopo prepare(), costo per blocco limitato dalla decimazione.
+// La FIFO è allocata una volta nel costruttore e svuotata solo dal lettore (anche dopo prepare).
+// Se l'editor è chiuso (setEnabled(false)) il thread audio non fa nulla.
+class TelemetryTap
+{
+public:
+    struct Point
+    {
+        float input[2]{}, output[2]{};            // campione al punto (sinistro, destro)
+        float inputPeak[2]{}, outputPeak[2]{};    // picco assoluto dall'ultimo punto
+        float modulation[2]{};                    // delay modulato (ms)
+    };
+
+    TelemetryTap() : fifo(TELEMETRY_FIFO_SIZE), fifoPoints(static_cast<size_t>(TELEMETRY_FIFO_SIZE)) {}
+
+    // Punti del blocco (fuori dal thread audio). L'editor può leggere intanto: la FIFO non si tocca,
+    // i punti della configurazione precedente li scarta il lettore (generation)
+    void prepare(double sampleRate, int maxBlockSize)
+    {
+        decimation = juce::jmax(1, juce::roundToInt(sampleRate / TELEMETRY_POINT_RATE));
+        blockPoints.assign(static_cast<size_t>(maxBlockSize / decimation + 1), Point{});
+        generation.fetch_add(1);
+
+        firstPosition = 0;
+        numBlockPoints = 0;
+        active = false;
+
+        for (int ch = 0; ch < 2; ++ch)
+            inputPeak[ch] = outputPeak[ch] = 0;
+    }
+
+    // Editor aperto/chiuso
+    void setEnabled(bool shouldBeEnabled) noexcept { enabled.store(shouldBeEnabled); }
+    double getPointRate(double sampleRate) const noexcept { return sampleRate / decimation; }
+
+    // ====== Thread audio ======
+    // Ingresso del blocco (prima dell'elaborazione): posizioni dei punti, valori e picchi
+    template <typename SampleType>
+    void beginBlock(const juce::AudioBuffer<SampleType>& input) noexcept
+    {
+        blockLength = input.getNumSamples();
+        active = enabled.load(std::memory_order_relaxed) && !blockPoints.empty();
+
+        if (!active)
+            return;
+
+        numBlockPoints = firstPosition < blockLength ? juce::jmin((blockLength - 1 - firstPosition) / decimation + 1, static_cast<int>(blockPoints.size())) : 0;
+        capture(input, inputPeak, [](Point& p) -> float* { return p.input; }, [](Point& p) -> float* { return p.inputPeak; });
+    }
+
+    // Delay modulato a ogni punto da un buffer di modulazione (anche sovracampionato o a control rate:
+    // numWetSamples campioni del blocco, un valore ogni controlInterval). Con più voci si mostra la prima di ogni canale
+    template <typename SampleType>
+    void captureModulation(const juce::AudioBuffer<SampleType>& modulation, int numWetSamples, int controlInterval, int numVoices = 1) noexcept
+    {
+        if (!active || blockLength == 0)
+            return;
+
+        const int numValues = juce::jmax(1, (numWetSamples + controlInterval - 1) / controlInterval);
+        const int numCh = modulation.getNumChannels() / numVoices;
+
+        for (int j = 0; j < numBlockPoints; ++j)
+        {
+            const int wetPosition = static_cast<int>(static_cast<juce::int64>(getPointPosition(j)) * numWetSamples / blockLength);
+            const int index = juce::jmin(wetPosition / controlInterval, numValues - 1);
+
+            for (int ch = 0; ch < 2; ++ch)
+                blockPoints[(size_t)j].modulation[ch] = static_cast<float>(modulation.getSample(juce::jmin(ch, numCh - 1) * numVoices, index));
+        }
+    }
+
+    // Delay modulato del punto j (percorso fuso) o di tutti i punti (modulazione ferma nel blocco),
+    // numVoices valori per canale: si mostra la prima voce dei primi due (il mono li ripete)
+    template <typename SampleType>
+    inline void setModulation(int j, const SampleType* modulationMs, int numChannels, int numVoices = 1) noexcept
+    {
+        for (int ch = 0; ch < 2; ++ch)
+            blockPoints[(size_t)j].modulation[ch] = static_cast<float>(modulationMs[juce::jmin(ch, numChannels - 1) * numVoices]);
+    }
+
+    template <typename SampleType>
+    void setModulation(const SampleType* modulationMs, int numChannels, int numVoices = 1) noexcept
+    {
+        if (active)
+            for (int j = 0; j < numBlockPoints; ++j)
+                setModulation(j, modulationMs, numChannels, numVoices);
+    }
+
+    // Campione del punto j nel blocco; oltre l'ultimo punto (o se inattivo) restituisce la lunghezza del blocco
+    inline int getPointPosition(int j) const noexcept
+    {
+        return active && j < numBlockPoints ? firstPosition + j * decimation : blockLength;
+    }
+
+    // Uscita del blocco, poi i punti vanno nella FIFO (quelli che non ci stanno sono scartati)
+    template <typename SampleType>
+    void endBlock(const juce::AudioBuffer<SampleType>& output) noexcept
+    {
+        if (!active)
+            return;
+
+        capture(output, outputPeak, [](Point& p) -> float* { return p.output; }, [](Point& p) -> float* { return p.outputPeak; });
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(numBlockPoints, start1, size1, start2, size2);
+
+        std::copy(blockPoints.begin(), blockPoints.begin() + size1, fifoPoints.begin() + start1);
+        std::copy(blockPoints.begin() + size1, blockPoints.begin() + size1 + size2, fifoPoints.begin() + start2);
+        fifo.finishedWrite(size1 + size2);
+
+        // Distanza dal prossimo punto all'inizio del blocco successivo
+        firstPosition = juce::jmax(0, firstPosition + numBlockPoints * decimation - blockLength);
+    }
+
+    // ====== Editor ======
+    // Copia fino a maxPoints punti in dest, restituisce quanti
+    int read(Point* dest, int maxPoints) noexcept
+    {
+        // Dopo un prepare i punti in coda sono della configurazione precedente
+        const auto currentGeneration = generation.load();
+        if (currentGeneration != readGeneration)
+        {
+            readGeneration = currentGeneration;
+            fifo.finishedRead(fifo.getNumReady());
+        }
+
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(maxPoints, start1, size1, start2, size2);
+
+        std::copy(fifoPoints.begin() + start1, fifoPoints.begin() + start1 + size1, dest);
+        std::copy(fifoPoints.begin() + start2, fifoPoints.begin() + start2 + size2, dest + size1);
+        fifo.finishedRead(size1 + size2);
+
+        return size1 + size2;
+    }
+
+private:
+    // Valore a ogni posizione e picco assoluto dei campioni dal punto precedente (anche a cavallo dei blocchi)
+    template <typename SampleType, typename Values, typename Peaks>
+    void capture(const juce::AudioBuffer<SampleType>& buffer, float* peakCarry, Values values, Peaks peaks) noexcept
+    {
+        const int numCh = buffer.getNumChannels();
+        if (numCh == 0)
+            return;
+
+        for (int ch = 0; ch < 2; ++ch)
+        {
+            const SampleType* data = buffer.getReadPointer(juce::jmin(ch, numCh - 1));
+            int from = 0;
+
+            for (int j = 0; j < numBlockPoints; ++j)
+            {
+                const int position = getPointPosition(j);
+                auto& point = blockPoints[(size_t)j];
+
+                values(point)[ch] = static_cast<float>(data[position]);
+                peaks(point)[ch] = juce::jmax(peakCarry[ch], getPeak(data + from, position + 1 - from));
+
+                peakCarry[ch] = 0;
+                from = position + 1;
+            }
+
+            peakCarry[ch] = juce::jmax(peakCarry[ch], getPeak(data + from, blockLength - from));
+        }
+    }
+
+    template <typename SampleType>
+    static float getPeak(const SampleType* data, int numSamples) noexcept
+    {
+        if (numSamples <= 0)
+            return 0;
+
+        const auto range = juce::FloatVectorOperations::findMinAndMax(data, numSamples);
+        return static_cast<float>(juce::jmax(-range.getStart(), range.getEnd()));
+    }
+
+    juce::AbstractFifo fifo;
+    std::vector<Point> fifoPoints;
+    std::vector<Point> blockPoints;     // punti del blocco corrente
+
+    int decimation = 1;
+    int firstPosition = 0;              // primo punto del blocco corrente
+    int numBlockPoints = 0;
+    int blockLength = 0;
+    bool active = false;
+    float inputPeak[2]{}, outputPeak[2]{};
+
+    std::atomic<bool> enabled{ false };
+    std::atomic<juce::uint32> generation{ 0 };      // prepare eseguiti (scritto fuori dal thread audio)
+    juce::uint32 readGeneration = 0;                // ultimo visto dal lettore
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(TelemetryTap)
+};
+
+// Capacità della FIFO dell'analizzatore, in campioni (circa 0.7 s a 48 kHz)
+#ifndef SPECTRUM_FIFO_SIZE
+#define SPECTRUM_FIFO_SIZE 32768
+#endif
+
+//==============================================================
+//                       SpectrumTap
+//==============================================================
+// Uscita del plugin (media dei canali) verso il thread di analisi dell'editor, a piena risoluzione.
+// Il thread audio copia soltanto; la FFT è fatta dal lettore (SpectrumAnalyzer, su un thread di lavoro).
+// Il buffer è allocato nel costruttore: prepare() non rialloca mentre il lettore può essere attivo.
+class SpectrumTap
+{
+public:
+    SpectrumTap() : fifo(SPECTRUM_FIFO_SIZE), samples(static_cast<size_t>(SPECTRUM_FIFO_SIZE), 0.0f) {}
+
+    void prepare(double newSampleRate) noexcept { sampleRate.store(newSampleRate); }
+
+    void setEnabled(bool shouldBeEnabled) noexcept { enabled.store(shouldBeEnabled); }
+    double getSampleRate() const noexcept { return sampleRate.load(); }
+
+    // ====== Thread audio ======
+    // I campioni che non stanno nella FIFO (lettore in ritardo) sono scartati
+    template <typename SampleType>
+    void push(const juce::AudioBuffer<SampleType>& output) noexcept
+    {
+        const int numCh = output.getNumChannels();
+        if (!enabled.load(std::memory_order_relaxed) || numCh == 0)
+            return;
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite(output.getNumSamples(), start1, size1, start2, size2);
+
+        const float channelGain = 1.0f / static_cast<float>(numCh);
+        auto mix = [&](int from, int start, int size)
+            {
+                for (int i = 0; i < size; ++i)
+                {
+                    SampleType sum = 0;
+                    for (int ch = 0; ch < numCh; ++ch)
+                        sum += output.getSample(ch, from + i);
+
+                    samples[(size_t)(start + i)] = static_cast<float>(sum) * channelGain;
+                }
+            };
+
+        mix(0, start1, size1);
+        mix(size1, start2, size2);
+        fifo.finishedWrite(size1 + size2);
+    }
+
+    // ====== Thread di analisi ======
+    int read(float* dest, int maxSamples) noexcept
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(maxSamples, start1, size1, start2, size2);
+
+        std::copy(samples.begin() + start1, samples.begin() + start1 + size1, dest);
+        std::copy(samples.begin() + start2, samples.begin() + start2 + size2, dest + size1);
+        fifo.finishedRead(size1 + size2);
+
+        return size1 + size2;
+    }
+
+private:
+    juce::AbstractFifo fifo;
+    std::vector<float> samples;
+
+    std::atomic<double> sampleRate{ 44100.0 };
+    std::atomic<bool> enabled{ false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumTap)
+};
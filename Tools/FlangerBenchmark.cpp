@@ -0,0 +1,810 @@
+#include <JuceHeader.h>
+#include <functional>
+#include <iostream>
+#include "../PluginProcessor.h"
+#include "ToolHelpers.h"
+
+//==============================================================================
+// FlangerBenchmark: tempi dei singoli stadi DSP e del processBlock completo.
+//
+// Per ogni combinazione di sample rate, dimensione del blocco, numero di
+// canali e variante (forma d'onda, tipo di filtro...) stampa una riga CSV:
+//
+//   stage,variant,sample_rate,block_size,channels,ns_per_sample,ns_per_channel_sample,x_realtime
+//
+// ns_per_sample è il tempo per frame (tutti i canali), x_realtime quante
+// istanze starebbero in tempo reale su un core.
+//
+//   FlangerBenchmark [--quick] [--stage <nome>] [--min-time <ms>] > results.csv
+//==============================================================================
+namespace
+{
+    struct BenchConfig
+    {
+        double sampleRate;
+        int blockSize;
+        int numChannels;
+    };
+
+    //==============================================================================
+    // Segnale di test lungo, processato a blocchi in place: ogni trial lavora su
+    // dati nuovi senza includere copie nel tempo misurato
+    template <typename SampleType = float>
+    class BenchSignal
+    {
+    public:
+        BenchSignal(const BenchConfig& config)
+        {
+            const int numBlocks = juce::jmax(8, totalFrames / config.blockSize);
+            signal.setSize(config.numChannels, numBlocks * config.blockSize);
+
+            for (int b = 0; b < numBlocks; ++b)
+                blocks.push_back(std::make_unique<juce::AudioBuffer<SampleType>>(signal.getArrayOfWritePointers(),
+                    config.numChannels, b * config.blockSize, config.blockSize));
+
+            refill();
+        }
+
+        void refill()
+        {
+            for (int ch = 0; ch < signal.getNumChannels(); ++ch)
+            {
+                auto* data = signal.getWritePointer(ch);
+                for (int s = 0; s < signal.getNumSamples(); ++s)
+                {
+                    seed = seed * 1664525u + 1013904223u;
+                    data[s] = static_cast<SampleType>(static_cast<float>(seed >> 8) * (1.0f / 16777216.0f) - 0.5f);
+                }
+            }
+        }
+
+        int getNumBlocks() const { return static_cast<int>(blocks.size()); }
+        int getNumFrames() const { return signal.getNumSamples(); }
+        juce::AudioBuffer<SampleType>& getBlock(int index) { return *blocks[(size_t)index]; }
+
+    private:
+        static constexpr int totalFrames = 65536;
+
+        juce::AudioBuffer<SampleType> signal;
+        std::vector<std::unique_ptr<juce::AudioBuffer<SampleType>>> blocks;
+        juce::uint32 seed = 0x1234567u;
+    };
+
+    //==============================================================================
+    class BenchmarkRunner
+    {
+    public:
+        explicit BenchmarkRunner(double minimumMs) : minimumSeconds(minimumMs * 0.001) {}
+
+        static void printHeader()
+        {
+            std::cout << "stage,variant,sample_rate,block_size,channels,ns_per_sample,ns_per_channel_sample,x_realtime" << std::endl;
+        }
+
+        // processBlock viene chiamata per ogni blocco del segnale; si riporta il trial migliore.
+        // SampleType: precisione dei blocchi passati a processBlock
+        template <typename SampleType = float, typename ProcessFunction>
+        void measure(const juce::String& stage, const juce::String& variant, const BenchConfig& config, ProcessFunction&& processBlock)
+        {
+            BenchSignal<SampleType> signal(config);
+            double bestSeconds = std::numeric_limits<double>::max();
+            double totalSeconds = 0.0;
+
+            for (int trial = 0; trial < minimumTrials || totalSeconds < minimumSeconds; ++trial)
+            {
+                signal.refill();
+
+                juce::ScopedNoDenormals noDenormals;
+                const auto start = juce::Time::getHighResolutionTicks();
+
+                for (int b = 0; b < signal.getNumBlocks(); ++b)
+                    processBlock(signal.getBlock(b));
+
+                const double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+                bestSeconds = juce::jmin(bestSeconds, seconds);
+                totalSeconds += seconds;
+            }
+
+            const double nsPerSample = bestSeconds * 1.0e9 / signal.getNumFrames();
+            const double realtimeFactor = 1.0e9 / (nsPerSample * config.sampleRate);
+
+            std::cout << stage << "," << variant << "," << config.sampleRate << "," << config.blockSize << ","
+                      << config.numChannels << "," << nsPerSample << "," << nsPerSample / config.numChannels << ","
+                      << realtimeFactor << std::endl;
+        }
+
+    private:
+        static constexpr int minimumTrials = 3;
+        double minimumSeconds;
+    };
+
+    // Stadi misurati in float e in double: le righe double hanno il suffisso "_double"
+    template <typename SampleType>
+    juce::String stageName(const char* name)
+    {
+        return std::is_same_v<SampleType, double> ? juce::String(name) + "_double" : juce::String(name);
+    }
+
+    const juce::StringArray waveformNames{ "sine", "triangle", "sawup", "sawdown", "square" };
+    const juce::StringArray filterNames{ "lowpass", "highpass", "bandpass" };
+    const juce::StringArray interpolationNames{ "linear", "hermite", "lagrange3", "thiran", "sinc" };
+
+    // Intervalli di control rate misurati (1 = audio rate)
+    const std::vector<int> controlIntervals{ 1, 8, 16, 32, 64 };
+
+    //==============================================================================
+    // Stadi singoli
+    template <typename SampleType>
+    void benchDelays(BenchmarkRunner& runner, const BenchConfig& config)
+    {
+        // modulazione costante: isola il costo di lettura/scrittura del delay
+        juce::AudioBuffer<SampleType> modulation(config.numChannels, config.blockSize);
+        for (int ch = 0; ch < config.numChannels; ++ch)
+            juce::FloatVectorOperations::fill(modulation.getWritePointer(ch), static_cast<SampleType>(Parameters::defaultDelay), config.blockSize);
+
+        for (int type = 0; type < interpolationNames.size(); ++type)
+        {
+            Delays<SampleType> delay(Parameters::defaultDelay, Parameters::defaultFeedback);
+            delay.setInterpolation(type);
+            delay.prepareToPlay(config.sampleRate, config.numChannels, config.blockSize);
+
+            runner.measure<SampleType>(stageName<SampleType>("delays"), interpolationNames[type], config, [&](juce::AudioBuffer<SampleType>& block)
+                {
+                    delay.processBlock(block, modulation);
+                });
+        }
+
+        // Delay time e feedback automatizzati a ogni blocco: kernel con le rampe dello smoothing
+        Delays<SampleType> delay(Parameters::defaultDelay, Parameters::defaultFeedback);
+        delay.prepareToPlay(config.sampleRate, config.numChannels, config.blockSize);
+        bool longer = false;
+
+        runner.measure<SampleType>(stageName<SampleType>("delays"), "linear_automated", config, [&](juce::AudioBuffer<SampleType>& block)
+            {
+                longer = !longer;
+                delay.setDelayTime(longer ? SampleType(8) : SampleType(2));
+                delay.setFeedback(longer ? SampleType(0.6) : SampleType(0.3));
+                delay.processBlock(block, modulation);
+            });
+
+        // Mono -> stereo: una linea condivisa letta a due prese
+        if (config.numChannels == 2)
+            for (const int type : { 0, 4 })
+            {
+                Delays<SampleType> shared(Parameters::defaultDelay, Parameters::defaultFeedback);
+                shared.setInterpolation(type);
+                shared.prepareToPlay(config.sampleRate, config.numChannels, config.blockSize, 1, true);
+
+                runner.measure<SampleType>(stageName<SampleType>("delays"), interpolationNames[type] + "_shared_line", config, [&](juce::AudioBuffer<SampleType>& block)
+                    {
+                        shared.processBlock(block, modulation);
+                    });
+            }
+
+        // Multi-voce: numVoices prese per linea, una modulazione per presa (voci distanziate di 0.05 ms)
+        for (const int numVoices : { 4, 16 })
+        {
+            juce::AudioBuffer<SampleType> voiceModulation(config.numChannels * numVoices, config.blockSize);
+            for (int tap = 0; tap < voiceModulation.getNumChannels(); ++tap)
+                juce::FloatVectorOperations::fill(voiceModulation.getWritePointer(tap),
+                    static_cast<SampleType>(Parameters::defaultDelay + 0.05 * (tap % numVoices)), config.blockSize);
+
+            for (const int type : { 0, 4 })
+            {
+                Delays<SampleType> voices(Parameters::defaultDelay, Parameters::defaultFeedback);
+                voices.setInterpolation(type);
+                voices.prepareToPlay(config.sampleRate, config.numChannels, config.blockSize);
+                voices.setNumVoices(numVoices);
+
+                runner.measure<SampleType>(stageName<SampleType>("delays"), interpolationNames[type] + "_voices_" + juce::String(numVoices), config, [&](juce::AudioBuffer<SampleType>& block)
+                    {
+                        voices.processBlock(block, voiceModulation);
+                    });
+            }
+        }
+    }
+
+    template <typename SampleType>
+    void benchModulation(BenchmarkRunner& runner, const BenchConfig& config)
+    {
+        for (int waveform = 0; waveform < waveformNames.size(); ++waveform)
+        {
+            NaiveOscillator<SampleType> lfo(Parameters::defaultModFrequency, static_cast<typename NaiveOscillator<SampleType>::Waveform>(waveform));
+            ParameterModulation<SampleType> modulator(Parameters::defaultDelay, Parameters::defaultModAmount, SampleType(0.25));
+            lfo.prepareToPlay(config.sampleRate, config.blockSize);
+            modulator.prepareToPlay(config.sampleRate, config.blockSize);
+
+            juce::AudioBuffer<SampleType> modulation(config.numChannels, config.blockSize);
+
+            runner.measure<SampleType>(stageName<SampleType>("modulation"), waveformNames[waveform], config, [&](juce::AudioBuffer<SampleType>&)
+                {
+                    modulator.process(modulation, lfo);
+                });
+        }
+
+        // Solo punti di controllo, senza l'interpolazione (che avviene in Delays)
+        for (const int interval : controlIntervals)
+        {
+            if (interval == 1)
+                continue;
+
+            NaiveOscillator<SampleType> lfo(Parameters::defaultModFrequency, NaiveOscillator<SampleType>::Sine);
+            ParameterModulation<SampleType> modulator(Parameters::defaultDelay, Parameters::defaultModAmount, SampleType(0.25));
+            lfo.prepareToPlay(config.sampleRate, config.blockSize);
+            modulator.prepareToPlay(config.sampleRate, config.blockSize);
+
+            juce::AudioBuffer<SampleType> controlPoints(config.numChannels, config.blockSize);
+
+            runner.measure<SampleType>(stageName<SampleType>("modulation"), "sine_interval_" + juce::String(interval), config, [&](juce::AudioBuffer<SampleType>&)
+                {
+                    modulator.processControlRate(controlPoints, lfo, config.blockSize, interval);
+                });
+        }
+    }
+
+    template <typename SampleType>
+    void benchFilter(BenchmarkRunner& runner, const BenchConfig& config)
+    {
+        for (int type = 0; type < filterNames.size(); ++type)
+        {
+            StereoFilter<SampleType> filter(Parameters::defaultFilterCutoff, Parameters::defaultQuality, type);
+            filter.prepareToPlay(config.sampleRate, config.numChannels, config.blockSize);
+
+            runner.measure<SampleType>(stageName<SampleType>("filter"), filterNames[type], config, [&](juce::AudioBuffer<SampleType>& block)
+                {
+                    filter.processBlock(block);
+                });
+        }
+
+        // Biquad un canale alla volta, per confronto con il percorso SIMD
+        for (int type = 0; type < filterNames.size(); ++type)
+        {
+            StereoFilter<SampleType> filter(Parameters::defaultFilterCutoff, Parameters::defaultQuality, type);
+            filter.setVectorised(false);
+            filter.prepareToPlay(config.sampleRate, config.numChannels, config.blockSize);
+
+            runner.measure<SampleType>(stageName<SampleType>("filter"), filterNames[type] + "_scalar", config, [&](juce::AudioBuffer<SampleType>& block)
+                {
+                    filter.processBlock(block);
+                });
+        }
+
+        for (int type = 0; type < filterNames.size(); ++type)
+        {
+            StereoFilter<SampleType> filter(Parameters::defaultFilterCutoff, Parameters::defaultQuality, type);
+            filter.setEngine(StereoFilter<SampleType>::StateVariable);
+            filter.prepareToPlay(config.sampleRate, config.numChannels, config.blockSize);
+
+            runner.measure<SampleType>(stageName<SampleType>("filter"), "svf_" + filterNames[type], config, [&](juce::AudioBuffer<SampleType>& block)
+                {
+                    filter.processBlock(block);
+                });
+        }
+
+        // Cutoff automatizzato a ogni blocco: il biquad ricalcola i coefficienti una volta
+        // per blocco, lo state-variable li ricalcola a ogni campione durante la rampa
+        for (const int engine : { StereoFilter<SampleType>::Biquad, StereoFilter<SampleType>::StateVariable })
+        {
+            StereoFilter<SampleType> filter(Parameters::defaultFilterCutoff, Parameters::defaultQuality, StereoFilter<SampleType>::LowPass);
+            filter.setEngine(engine);
+            filter.prepareToPlay(config.sampleRate, config.numChannels, config.blockSize);
+            bool up = false;
+
+            runner.measure<SampleType>(stageName<SampleType>("filter"), engine == StereoFilter<SampleType>::Biquad ? "automated" : "svf_automated", config, [&](juce::AudioBuffer<SampleType>& block)
+                {
+                    up = !up;
+                    filter.setFrequency(up ? SampleType(4000) : SampleType(1000));
+                    filter.updateCoefficients();
+                    filter.processBlock(block);
+                });
+        }
+
+        // Cutoff pilotato dall'LFO (2 ottave), a audio rate e a control rate
+        for (const int interval : controlIntervals)
+        {
+            if (interval != 1 && interval != 16)
+                continue;
+
+            NaiveOscillator<SampleType> lfo(Parameters::defaultModFrequency, NaiveOscillator<SampleType>::Sine);
+            lfo.prepareToPlay(config.sampleRate, config.blockSize);
+
+            StereoFilter<SampleType> filter(Parameters::defaultFilterCutoff, Parameters::defaultQuality, StereoFilter<SampleType>::LowPass);
+            filter.setEngine(StereoFilter<SampleType>::StateVariable);
+            filter.setModulationDepth(2);
+            filter.prepareToPlay(config.sampleRate, config.numChannels, config.blockSize);
+
+            juce::AudioBuffer<SampleType> lfoPoints(config.numChannels, config.blockSize);
+            const int numPoints = (config.blockSize + interval - 1) / interval;
+
+            const juce::String variant = interval == 1 ? juce::String("svf_lfo") : "svf_lfo_interval_" + juce::String(interval);
+
+            runner.measure<SampleType>(stageName<SampleType>("filter"), variant, config, [&](juce::AudioBuffer<SampleType>& block)
+                {
+                    lfo.renderBlock(lfoPoints.getArrayOfWritePointers(), config.numChannels,
+                        NaiveOscillator<SampleType>::cyclesToPhase(0.25), numPoints);
+                    filter.processBlock(block, &lfoPoints, interval);
+                });
+        }
+    }
+
+    template <typename SampleType>
+    void benchDryWet(BenchmarkRunner& runner, const BenchConfig& config)
+    {
+        DryWet<SampleType> drywet(SampleType(0.5));
+        drywet.prepareToPlay(config.sampleRate, config.numChannels, config.blockSize);
+
+        runner.measure<SampleType>(stageName<SampleType>("drywet"), "copy", config, [&](juce::AudioBuffer<SampleType>& block)
+            {
+                drywet.copyDrySignal(block);
+            });
+
+        runner.measure<SampleType>(stageName<SampleType>("drywet"), "mix", config, [&](juce::AudioBuffer<SampleType>& block)
+            {
+                drywet.mixDrySignal(block);
+            });
+
+        // mix e gain sempre in smoothing: percorso con rampa per blocco
+        bool rising = false;
+        runner.measure<SampleType>(stageName<SampleType>("drywet"), "mix_ramp", config, [&](juce::AudioBuffer<SampleType>& block)
+            {
+                rising = !rising;
+                drywet.setDryWetRatio(rising ? SampleType(0.6) : SampleType(0.4));
+                drywet.setOutputGain(rising ? SampleType(-1) : SampleType(1));
+                drywet.mixDrySignal(block);
+            });
+    }
+
+    //==============================================================================
+    // processBlock completo, nella precisione di SampleType (catena float o double)
+    template <typename SampleType>
+    void benchProcessorModes(BenchmarkRunner& runner, const BenchConfig& config, FlangerAudioProcessor& processor, const juce::String& prefix)
+    {
+        juce::MidiBuffer midi;
+        processor.setProcessingPrecision(std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                                             : juce::AudioProcessor::singlePrecision);
+
+        for (const auto mode : { FlangerAudioProcessor::ProcessingMode::staged, FlangerAudioProcessor::ProcessingMode::fused })
+            for (const bool filterActive : { false, true })
+            {
+                ToolHelpers::setParameter(processor, Parameters::nameDryWet, 0.5f);
+                ToolHelpers::setParameter(processor, Parameters::nameFilterActive, filterActive ? 1.0f : 0.0f);
+                processor.setProcessingMode(mode);
+
+                processor.setRateAndBufferSizeDetails(config.sampleRate, config.blockSize);
+                processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+                const juce::String variant = prefix + (mode == FlangerAudioProcessor::ProcessingMode::fused ? "fused" : "staged")
+                    + (filterActive ? "_filter_on" : "_filter_off");
+
+                runner.measure<SampleType>(stageName<SampleType>("processor"), variant, config, [&](juce::AudioBuffer<SampleType>& block)
+                    {
+                        processor.processBlock(block, midi);
+                    });
+
+                processor.releaseResources();
+            }
+    }
+
+    // In stereo anche il layout mono -> stereo (varianti "mono_in_", linea condivisa)
+    template <typename SampleType>
+    void benchProcessor(BenchmarkRunner& runner, const BenchConfig& config)
+    {
+        for (const bool monoInput : { false, true })
+        {
+            if (monoInput && config.numChannels != 2)
+                continue;
+
+            FlangerAudioProcessor processor;
+            if (!ToolHelpers::setChannelCount(processor, monoInput ? 1 : config.numChannels, config.numChannels))
+                continue;
+
+            benchProcessorModes<SampleType>(runner, config, processor, monoInput ? "mono_in_" : "");
+        }
+    }
+
+    //==============================================================================
+    // processBlock completo con ingresso silenzioso, con e senza rilevamento del silenzio
+    void benchSilence(BenchmarkRunner& runner, const BenchConfig& config)
+    {
+        FlangerAudioProcessor processor;
+        if (config.numChannels != processor.getTotalNumOutputChannels())
+            return;
+
+        juce::MidiBuffer midi;
+
+        for (const bool detection : { false, true })
+        {
+            ToolHelpers::setParameter(processor, Parameters::nameDryWet, 0.5f);
+            processor.setSilenceDetection(detection);
+
+            processor.setRateAndBufferSizeDetails(config.sampleRate, config.blockSize);
+            processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+            // Coda esaurita prima della misura
+            juce::AudioBuffer<float> silence(config.numChannels, config.blockSize);
+            const int warmupBlocks = static_cast<int>(std::ceil((processor.getTailLengthSeconds() + 0.1) * config.sampleRate / config.blockSize));
+
+            for (int b = 0; b < warmupBlocks; ++b)
+            {
+                silence.clear();
+                processor.processBlock(silence, midi);
+            }
+
+            jassert(processor.isIdle() == detection);
+
+            runner.measure("silence", detection ? "detection_on" : "detection_off", config, [&](juce::AudioBuffer<float>& block)
+                {
+                    block.clear();
+                    processor.processBlock(block, midi);
+                });
+
+            processor.releaseResources();
+        }
+    }
+
+    //==============================================================================
+    // processBlock con ingresso stereo a canali identici, con e senza rilevamento (catena su un solo canale)
+    void benchCorrelated(BenchmarkRunner& runner, const BenchConfig& config)
+    {
+        FlangerAudioProcessor processor;
+        if (config.numChannels != 2 || config.numChannels != processor.getTotalNumOutputChannels())
+            return;
+
+        juce::MidiBuffer midi;
+
+        for (const bool detection : { false, true })
+        {
+            ToolHelpers::setParameter(processor, Parameters::nameDryWet, 0.5f);
+            processor.setMonoDetection(detection);
+
+            processor.setRateAndBufferSizeDetails(config.sampleRate, config.blockSize);
+            processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+            // Più di un giro della memoria con ingressi identici prima della misura
+            BenchSignal<float> warmup(config);
+
+            for (int b = 0; b < warmup.getNumBlocks(); ++b)
+            {
+                auto& block = warmup.getBlock(b);
+                block.copyFrom(1, 0, block, 0, 0, block.getNumSamples());
+                processor.processBlock(block, midi);
+            }
+
+            jassert(processor.isMonoFolded() == detection);
+
+            runner.measure("correlated", detection ? "detection_on" : "detection_off", config, [&](juce::AudioBuffer<float>& block)
+                {
+                    block.copyFrom(1, 0, block, 0, 0, block.getNumSamples());
+                    processor.processBlock(block, midi);
+                });
+
+            processor.releaseResources();
+        }
+    }
+
+    //==============================================================================
+    // processBlock completo con mix agli estremi (percorsi rapidi tutto dry / tutto wet) e a metà
+    void benchMixExtremes(BenchmarkRunner& runner, const BenchConfig& config)
+    {
+        FlangerAudioProcessor processor;
+        if (config.numChannels != processor.getTotalNumOutputChannels())
+            return;
+
+        juce::MidiBuffer midi;
+
+        for (const float mix : { 0.0f, 0.5f, 1.0f })
+        {
+            ToolHelpers::setParameter(processor, Parameters::nameDryWet, mix);
+            ToolHelpers::setParameter(processor, Parameters::nameFeedback, 0.8f);
+
+            processor.setRateAndBufferSizeDetails(config.sampleRate, config.blockSize);
+            processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+            const juce::String variant = mix == 0.0f ? "dry" : (mix == 1.0f ? "wet" : "mix_half");
+
+            runner.measure("mix_extremes", variant, config, [&](juce::AudioBuffer<float>& block)
+                {
+                    processor.processBlock(block, midi);
+                });
+
+            processor.releaseResources();
+        }
+    }
+
+    //==============================================================================
+    // processBlock completo con modulazione a control rate
+    void benchControlRate(BenchmarkRunner& runner, const BenchConfig& config)
+    {
+        FlangerAudioProcessor processor;
+        if (config.numChannels != processor.getTotalNumOutputChannels())
+            return;
+
+        juce::MidiBuffer midi;
+        ToolHelpers::setParameter(processor, Parameters::nameDryWet, 0.5f);
+
+        for (const int interval : controlIntervals)
+        {
+            processor.setControlInterval(interval);
+            processor.setRateAndBufferSizeDetails(config.sampleRate, config.blockSize);
+            processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+            runner.measure("control_rate", "interval_" + juce::String(interval), config, [&](juce::AudioBuffer<float>& block)
+                {
+                    processor.processBlock(block, midi);
+                });
+
+            processor.releaseResources();
+        }
+    }
+
+    //==============================================================================
+    // processBlock completo per ogni fattore di oversampling (filtro attivo)
+    void benchOversampling(BenchmarkRunner& runner, const BenchConfig& config)
+    {
+        FlangerAudioProcessor processor;
+        if (config.numChannels != processor.getTotalNumOutputChannels())
+            return;
+
+        juce::MidiBuffer midi;
+        ToolHelpers::setParameter(processor, Parameters::nameDryWet, 0.5f);
+        ToolHelpers::setParameter(processor, Parameters::nameFilterActive, 1.0f);
+
+        for (int order = 0; order <= FlangerAudioProcessor::maxOversamplingOrder; ++order)
+        {
+            ToolHelpers::setParameter(processor, Parameters::nameOversampling, static_cast<float>(order));
+            processor.setRateAndBufferSizeDetails(config.sampleRate, config.blockSize);
+            processor.prepareToPlay(config.sampleRate, config.blockSize);
+
+            runner.measure("oversampling", juce::String(1 << order) + "x", config, [&](juce::AudioBuffer<float>& block)
+                {
+                    processor.processBlock(block, midi);
+                });
+
+            processor.releaseResources();
+        }
+    }
+
+    void reportOversamplingLatency()
+    {
+        FlangerAudioProcessor processor;
+
+        for (int order = 1; order <= FlangerAudioProcessor::maxOversamplingOrder; ++order)
+        {
+            ToolHelpers::setParameter(processor, Parameters::nameOversampling, static_cast<float>(order));
+            processor.prepareToPlay(48000.0, 512);
+
+            std::cerr << "oversampling " << (1 << order) << "x: latency " << processor.getLatencySamples() << " samples" << std::endl;
+            processor.releaseResources();
+        }
+    }
+
+    //==============================================================================
+    // Differenza tra due processori sullo stesso segnale
+    struct Difference
+    {
+        float maxError = 0.0f;
+        double rmsError = 0.0;
+    };
+
+    Difference compareProcessors(FlangerAudioProcessor& reference, FlangerAudioProcessor& test,
+        const std::function<void(FlangerAudioProcessor&)>& setup)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 256;
+        constexpr int numBlocks = 400;
+
+        for (auto* processor : { &reference, &test })
+        {
+            setup(*processor);
+            processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+            processor->prepareToPlay(sampleRate, blockSize);
+        }
+
+        BenchSignal signal({ sampleRate, blockSize, reference.getTotalNumOutputChannels() });
+        juce::AudioBuffer<float> copy;
+        juce::MidiBuffer midi;
+        Difference difference;
+        double sumOfSquares = 0.0;
+
+        for (int b = 0; b < numBlocks; ++b)
+        {
+            auto& block = signal.getBlock(b % signal.getNumBlocks());
+            copy.makeCopyOf(block);
+
+            reference.processBlock(block, midi);
+            test.processBlock(copy, midi);
+
+            for (int ch = 0; ch < block.getNumChannels(); ++ch)
+                for (int s = 0; s < block.getNumSamples(); ++s)
+                {
+                    const float error = std::abs(block.getSample(ch, s) - copy.getSample(ch, s));
+                    difference.maxError = juce::jmax(difference.maxError, error);
+                    sumOfSquares += static_cast<double>(error) * error;
+                }
+
+            if ((b + 1) % signal.getNumBlocks() == 0)
+                signal.refill();
+        }
+
+        difference.rmsError = std::sqrt(sumOfSquares / (static_cast<double>(numBlocks) * blockSize * reference.getTotalNumOutputChannels()));
+        return difference;
+    }
+
+    // Confronto tra motore fuso e a stadi: massimo errore assoluto
+    float compareProcessingModes()
+    {
+        FlangerAudioProcessor staged, fused;
+        fused.setProcessingMode(FlangerAudioProcessor::ProcessingMode::fused);
+
+        return compareProcessors(staged, fused, [](FlangerAudioProcessor& processor)
+            {
+                ToolHelpers::setParameter(processor, Parameters::nameDryWet, 0.5f);
+                ToolHelpers::setParameter(processor, Parameters::nameFeedback, 0.9f);
+                ToolHelpers::setParameter(processor, Parameters::nameModFrequency, 2.0f);
+                ToolHelpers::setParameter(processor, Parameters::namePhaseDelta, 0.25f);
+                ToolHelpers::setParameter(processor, Parameters::nameFilterActive, 1.0f);
+            }).maxError;
+    }
+
+    // Errore della modulazione a control rate rispetto all'audio rate, nel caso peggiore
+    // (LFO alla frequenza e profondità massime, solo segnale wet)
+    void reportControlRateError()
+    {
+        for (const int interval : controlIntervals)
+        {
+            if (interval == 1)
+                continue;
+
+            FlangerAudioProcessor audioRate, controlRate;
+            controlRate.setControlInterval(interval);
+
+            const auto difference = compareProcessors(audioRate, controlRate, [](FlangerAudioProcessor& processor)
+                {
+                    ToolHelpers::setParameter(processor, Parameters::nameDryWet, 1.0f);
+                    ToolHelpers::setParameter(processor, Parameters::nameFeedback, 0.9f);
+                    ToolHelpers::setParameter(processor, Parameters::nameModFrequency, Parameters::maxModFrequency);
+                    ToolHelpers::setParameter(processor, Parameters::nameModAmount, Parameters::maxModAmount);
+                });
+
+            std::cerr << "control interval " << interval << ": max abs error " << difference.maxError
+                      << ", rms error " << juce::Decibels::gainToDecibels(difference.rmsError, -200.0) << " dBFS" << std::endl;
+        }
+    }
+
+    // Qualità degli interpolatori: sinusoide attraverso un ritardo modulato lentamente
+    // (senza feedback) confrontata con la sinusoide ritardata esatta. Stampa il rapporto
+    // errore/segnale in dB per alcune frequenze a 48 kHz
+    void reportInterpolationQuality()
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int blockSize = 256;
+        constexpr int numBlocks = 200;
+        constexpr int settleBlocks = 20;
+
+        std::cerr << "interpolation error (dB re signal) at 1k / 5k / 10k / 15k Hz:" << std::endl;
+
+        for (int type = 0; type < interpolationNames.size(); ++type)
+        {
+            juce::String line = "  " + interpolationNames[type].paddedRight(' ', 10);
+
+            for (const double frequency : { 1000.0, 5000.0, 10000.0, 15000.0 })
+            {
+                Delays<float> delay(0.0f, 0.0f);
+                delay.setInterpolation(type);
+                delay.prepareToPlay(sampleRate, 1, blockSize);
+
+                juce::AudioBuffer<float> block(1, blockSize), modulation(1, blockSize);
+                const double omega = juce::MathConstants<double>::twoPi * frequency / sampleRate;
+                double errorEnergy = 0.0, signalEnergy = 0.0;
+
+                for (int b = 0; b < numBlocks; ++b)
+                    for (int pass = 0; pass < 2; ++pass)
+                    {
+                        // pass 0: prepara i buffer, pass 1: processa e confronta
+                        for (int i = 0; i < blockSize; ++i)
+                        {
+                            const double n = static_cast<double>(b * blockSize + i);
+                            const double delayMs = 5.0 + std::sin(juce::MathConstants<double>::twoPi * 0.5 * n / sampleRate);
+                            const double expected = std::sin(omega * (n - delayMs * 0.001 * sampleRate));
+
+                            if (pass == 0)
+                            {
+                                block.setSample(0, i, static_cast<float>(std::sin(omega * n)));
+                                modulation.setSample(0, i, static_cast<float>(delayMs));
+                            }
+                            else if (b >= settleBlocks)
+                            {
+                                const double error = block.getSample(0, i) - expected;
+                                errorEnergy += error * error;
+                                signalEnergy += expected * expected;
+                            }
+                        }
+
+                        if (pass == 0)
+                            delay.processBlock(block, modulation);
+                    }
+
+                line << juce::String(10.0 * std::log10(errorEnergy / signalEnergy + 1.0e-20), 1).paddedLeft(' ', 8);
+            }
+
+            std::cerr << line << std::endl;
+        }
+    }
+
+    //==============================================================================
+    struct Stage
+    {
+        const char* name;
+        void (*run)(BenchmarkRunner&, const BenchConfig&);
+        int maxChannels;
+    };
+
+    // maxChannels: gli stadi che scalano con i canali girano anche in 5.1 e 7.1.4
+    const Stage stages[] = {
+        { "delays",       benchDelays<float>,      FlangerAudioProcessor::maxChannels },
+        { "modulation",   benchModulation<float>,  FlangerAudioProcessor::maxChannels },
+        { "filter",       benchFilter<float>,      FlangerAudioProcessor::maxChannels },
+        { "drywet",       benchDryWet<float>,      FlangerAudioProcessor::maxChannels },
+        { "processor",    benchProcessor<float>,   FlangerAudioProcessor::maxChannels },
+        { "silence",      benchSilence,     2 },
+        { "correlated",   benchCorrelated,  2 },
+        { "mix_extremes", benchMixExtremes, 2 },
+        { "control_rate", benchControlRate, 2 },
+        { "oversampling", benchOversampling, 2 },
+        { "delays_double",     benchDelays<double>,     2 },
+        { "modulation_double", benchModulation<double>, 2 },
+        { "filter_double",     benchFilter<double>,     2 },
+        { "drywet_double",     benchDryWet<double>,     2 },
+        { "processor_double",  benchProcessor<double>,  2 },
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const juce::ArgumentList args(argc, argv);
+
+    const bool quick = args.containsOption("--quick");
+    const auto stageFilter = args.getValueForOption("--stage");
+    const double minimumMs = args.containsOption("--min-time") ? args.getValueForOption("--min-time").getDoubleValue() : 20.0;
+
+    const std::vector<double> sampleRates = quick ? std::vector<double>{ 48000.0, 192000.0 }
+                                                  : std::vector<double>{ 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+    const std::vector<int> blockSizes = quick ? std::vector<int>{ 64, 512, 4096 }
+                                              : std::vector<int>{ 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+    const std::vector<int> channelCounts{ 1, 2, 6, 12 };
+
+    // Il motore fuso deve restare intercambiabile con quello a stadi
+    constexpr float maxModeError = 1.0e-5f;
+    const float modeError = compareProcessingModes();
+    std::cerr << "fused vs staged: max abs error " << modeError << std::endl;
+
+    if (modeError > maxModeError)
+    {
+        std::cerr << "fused engine differs from staged engine by more than " << maxModeError << std::endl;
+        return 1;
+    }
+
+    reportControlRateError();
+    reportInterpolationQuality();
+    reportOversamplingLatency();
+
+    BenchmarkRunner runner(minimumMs);
+    BenchmarkRunner::printHeader();
+
+    for (const auto& stage : stages)
+    {
+        if (stageFilter.isNotEmpty() && stageFilter != stage.name)
+            continue;
+
+        std::cerr << "benchmarking " << stage.name << "..." << std::endl;
+
+        for (const double sampleRate : sampleRates)
+            for (const int blockSize : blockSizes)
+                for (const int numChannels : channelCounts)
+                    if (numChannels <= stage.maxChannels)
+                        stage.run(runner, { sampleRate, blockSize, numChannels });
+    }
+
+    return 0;
+}
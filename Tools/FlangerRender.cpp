@@ -0,0 +1,247 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include "../PluginProcessor.h"
+#include "ToolHelpers.h"
+
+//==============================================================================
+// FlangerRender: render offline di file audio (WAV/AIFF/FLAC) attraverso
+// FlangerAudioProcessor, senza editor né host.
+//
+//   FlangerRender -i input.wav -o output.wav [--state preset.xml]
+//                 [--set delayTime=3.5 --set feedback=0.7 ...]
+//                 [--block 512] [--tail 2.0] [--bits 24] [--engine fused]
+//                 [--control-interval 16] [--double] [--stereo] [--list]
+//==============================================================================
+namespace
+{
+    void printUsage()
+    {
+        std::cout << "Usage: FlangerRender -i <input> -o <output> [options]\n"
+                     "  -i, --input <file>     file da processare (wav, aiff, flac)\n"
+                     "  -o, --output <file>    file di uscita, formato dall'estensione\n"
+                     "  --state <file>         stato del plugin (XML o binario di getStateInformation)\n"
+                     "  --set <id>=<valore>    imposta un parametro in unità reali (ripetibile)\n"
+                     "  --block <n>            dimensione del blocco (default 512)\n"
+                     "  --tail <secondi>       silenzio aggiunto in coda (default: getTailLengthSeconds)\n"
+                     "  --bits <n>             bit di uscita (default: come l'ingresso)\n"
+                     "  --engine <nome>        staged | fused (default staged)\n"
+                     "  --control-interval <n> modulazione a control rate ogni n campioni (1 = audio rate)\n"
+                     "  --double               elabora in doppia precisione (processBlock double)\n"
+                     "  --stereo               ingresso mono, uscita stereo (layout mono -> stereo)\n"
+                     "  --list                 elenca i parametri disponibili\n";
+    }
+}
+
+static int render(const juce::ArgumentList& args)
+{
+    using juce::ConsoleApplication;
+
+    if (args.containsOption("--help|-h") || args.size() == 0)
+    {
+        printUsage();
+        return 0;
+    }
+
+    FlangerAudioProcessor processor;
+
+    if (args.containsOption("--list"))
+    {
+        ToolHelpers::printParameters(processor);
+        return 0;
+    }
+
+    const auto inputFile = args.getExistingFileForOption("--input|-i");
+    const auto outputFile = args.getFileForOption("--output|-o");
+    const int blockSize = args.containsOption("--block") ? args.getValueForOption("--block").getIntValue() : 512;
+
+    if (blockSize <= 0)
+        ConsoleApplication::fail("dimensione del blocco non valida");
+
+    // ====== Ingresso ======
+    juce::AudioFormatManager formatManager;
+    formatManager.registerBasicFormats();
+
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(inputFile));
+    if (reader == nullptr)
+        ConsoleApplication::fail("impossibile leggere " + inputFile.getFullPathName());
+
+    const double sampleRate = reader->sampleRate;
+    const auto numInputSamples = reader->lengthInSamples;
+
+    // Bus con i canali del file (mono, stereo o multicanale); --stereo: file mono su uscita stereo
+    const int numFileChannels = static_cast<int>(reader->numChannels);
+
+    if (args.containsOption("--stereo"))
+    {
+        if (numFileChannels != 1 || !ToolHelpers::setChannelCount(processor, 1, 2))
+            ConsoleApplication::fail("--stereo richiede un file mono");
+    }
+    else if (!ToolHelpers::setChannelCount(processor, numFileChannels))
+    {
+        ConsoleApplication::fail("layout a " + juce::String(numFileChannels) + " canali non supportato");
+    }
+
+    // ====== Stato e parametri ======
+    if (args.containsOption("--state"))
+    {
+        const auto stateFile = args.getExistingFileForOption("--state");
+        if (!ToolHelpers::loadStateFile(processor, stateFile))
+            ConsoleApplication::fail("impossibile caricare lo stato da " + stateFile.getFullPathName());
+    }
+
+    for (int i = 0; i < args.size() - 1; ++i)
+    {
+        if (args[i] != "--set")
+            continue;
+
+        const auto assignment = args[i + 1].text;
+        if (!ToolHelpers::setParameterFromString(processor, assignment))
+            ConsoleApplication::fail("parametro non valido: " + assignment + " (usa --list)");
+    }
+
+    if (args.containsOption("--engine"))
+    {
+        const auto engine = args.getValueForOption("--engine");
+        if (engine == "fused")
+            processor.setProcessingMode(FlangerAudioProcessor::ProcessingMode::fused);
+        else if (engine != "staged")
+            ConsoleApplication::fail("motore sconosciuto: " + engine);
+    }
+
+    if (args.containsOption("--control-interval"))
+    {
+        const int interval = args.getValueForOption("--control-interval").getIntValue();
+        if (interval < 1 || interval > FlangerAudioProcessor::maxControlInterval)
+            ConsoleApplication::fail("--control-interval deve essere tra 1 e " + juce::String(FlangerAudioProcessor::maxControlInterval));
+
+        processor.setControlInterval(interval);
+    }
+
+    // Doppia precisione: la precisione va scelta prima di prepareToPlay
+    const bool doublePrecision = args.containsOption("--double");
+    if (doublePrecision)
+        processor.setProcessingPrecision(juce::AudioProcessor::doublePrecision);
+
+    processor.setNonRealtime(true);
+    processor.setRateAndBufferSizeDetails(sampleRate, blockSize);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    const int numOutputChannels = processor.getTotalNumOutputChannels();
+    const int numChannels = juce::jmax(processor.getTotalNumInputChannels(), numOutputChannels);
+
+    const double tailSeconds = args.containsOption("--tail") ? args.getValueForOption("--tail").getDoubleValue()
+                                                             : processor.getTailLengthSeconds();
+    const auto totalSamples = numInputSamples + static_cast<juce::int64>(std::ceil(juce::jmax(0.0, tailSeconds) * sampleRate));
+
+    // ====== Uscita ======
+    auto* outputFormat = formatManager.findFormatForFileExtension(outputFile.getFileExtension());
+    if (outputFormat == nullptr)
+        ConsoleApplication::fail("formato di uscita non supportato: " + outputFile.getFileName());
+
+    const int bitsPerSample = args.containsOption("--bits") ? args.getValueForOption("--bits").getIntValue()
+                                                            : static_cast<int>(reader->bitsPerSample);
+
+    outputFile.deleteFile();
+    std::unique_ptr<juce::OutputStream> outputStream(outputFile.createOutputStream());
+    std::unique_ptr<juce::AudioFormatWriter> writer;
+
+    if (outputStream != nullptr)
+        writer.reset(outputFormat->createWriterFor(outputStream.get(), sampleRate,
+            static_cast<unsigned int>(numOutputChannels), bitsPerSample, {}, 0));
+
+    if (writer == nullptr)
+        ConsoleApplication::fail("impossibile scrivere " + outputFile.getFullPathName());
+
+    outputStream.release(); // ora è di proprietà del writer
+
+    // ====== Render ======
+    juce::AudioBuffer<float> buffer(numChannels, blockSize);
+    juce::AudioBuffer<double> doubleBuffer(doublePrecision ? numChannels : 0, doublePrecision ? blockSize : 0);
+    juce::MidiBuffer midi;
+    juce::int64 processingTicks = 0;
+
+    for (juce::int64 position = 0; position < totalSamples; position += blockSize)
+    {
+        const int numSamples = static_cast<int>(juce::jmin<juce::int64>(blockSize, totalSamples - position));
+
+        buffer.setSize(numChannels, numSamples, false, false, true);
+        buffer.clear();
+
+        if (position < numInputSamples)
+        {
+            const int numToRead = static_cast<int>(juce::jmin<juce::int64>(numSamples, numInputSamples - position));
+            reader->read(&buffer, 0, numToRead, position, true, true);
+        }
+
+        if (doublePrecision)
+        {
+            // Conversioni fuori dal tempo misurato
+            doubleBuffer.makeCopyOf(buffer, true);
+
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            processor.processBlock(doubleBuffer, midi);
+            processingTicks += juce::Time::getHighResolutionTicks() - startTicks;
+
+            buffer.makeCopyOf(doubleBuffer, true);
+        }
+        else
+        {
+            const auto startTicks = juce::Time::getHighResolutionTicks();
+            processor.processBlock(buffer, midi);
+            processingTicks += juce::Time::getHighResolutionTicks() - startTicks;
+        }
+
+        writer->writeFromAudioSampleBuffer(buffer, 0, numSamples);
+    }
+
+    const auto memoryFootprint = processor.getMemoryFootprint();
+#if FLANGER_DSP_PROFILING
+    const auto load = processor.getLoadMeter().getSnapshot();
+#endif
+    processor.releaseResources();
+    writer.reset();
+
+    // ====== Report ======
+    const double audioSeconds = static_cast<double>(totalSamples) / sampleRate;
+    const double processingSeconds = juce::Time::highResolutionTicksToSeconds(processingTicks);
+    const double realtimeFactor = processingSeconds > 0.0 ? audioSeconds / processingSeconds : 0.0;
+
+    std::cout << outputFile.getFullPathName() << "\n"
+              << "  audio:      " << audioSeconds << " s @ " << sampleRate << " Hz, "
+              << numOutputChannels << " ch, block " << blockSize << (doublePrecision ? ", double" : "") << "\n"
+              << "  memory:     " << static_cast<double>(memoryFootprint) / 1024.0 << " KiB\n"
+              << "  processing: " << processingSeconds << " s\n"
+              << "  throughput: " << realtimeFactor << "x realtime" << std::endl;
+
+#if FLANGER_DSP_PROFILING
+    // Carico misurato dal processore, in percentuale della durata di ogni blocco
+    std::cout << "  load:       avg " << load.averageLoad * 100.0 << "%, min " << load.minLoad * 100.0
+              << "%, max " << load.maxLoad * 100.0 << "% (" << load.numBlocks << " blocks)\n"
+              << "  stages:    ";
+
+    for (int s = 0; s < DspLoadMeter::numStages; ++s)
+        if (load.stageLoad[(size_t)s] > 0.0)
+            std::cout << " " << DspLoadMeter::getStageName(s) << " " << load.stageLoad[(size_t)s] * 100.0 << "%";
+
+    std::cout << "\n  histogram: ";
+
+    for (int b = 0; b < DspLoadMeter::numHistogramBins; ++b)
+    {
+        const bool last = b == DspLoadMeter::numHistogramBins - 1;
+        const double edge = DspLoadMeter::histogramEdges[(size_t)(last ? b - 1 : b)] * 100.0;
+        std::cout << " " << (last ? ">=" : "<") << edge << "%: " << load.histogram[(size_t)b];
+    }
+
+    std::cout << std::endl;
+#endif
+
+    return 0;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const juce::ArgumentList args(argc, argv);
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&] { return render(args); });
+}
@@ -0,0 +1,317 @@
+#include <JuceHeader.h>
+#include <iostream>
+#include "../PluginProcessor.h"
+#include "../Presets.h"
+#include "ToolHelpers.h"
+
+//==============================================================================
+// FlangerTests: test di regressione (juce::UnitTest) sul formato dello stato e
+// sull'equivalenza dei motori DSP. Codice di uscita 1 se almeno un test fallisce.
+//
+//   FlangerTests [--category <nome>]
+//==============================================================================
+namespace
+{
+    // Valori reali di default di tutti i parametri, nell'ordine di Parameters::allIDs
+    Presets::Values getDefaultValues(FlangerAudioProcessor& processor)
+    {
+        Presets::Values values{};
+
+        for (int i = 0; i < Parameters::numParameters; ++i)
+            if (auto* param = ToolHelpers::findParameter(processor, Parameters::allIDs[i]))
+                values[(size_t)i] = param->convertFrom0to1(param->getDefaultValue());
+
+        return values;
+    }
+
+    Presets::Values getCurrentValues(FlangerAudioProcessor& processor)
+    {
+        Presets::Values values{};
+
+        for (int i = 0; i < Parameters::numParameters; ++i)
+            if (auto* param = ToolHelpers::findParameter(processor, Parameters::allIDs[i]))
+                values[(size_t)i] = param->convertFrom0to1(param->getValue());
+
+        return values;
+    }
+
+    //==============================================================================
+    // Formato binario dello stato (Presets.h) e compatibilità con l'XML delle versioni precedenti
+    class StateFormatTests : public juce::UnitTest
+    {
+    public:
+        StateFormatTests() : juce::UnitTest("State format", "FlangeFlicker") {}
+
+        void runTest() override
+        {
+            FlangerAudioProcessor processor;
+            const auto defaults = getDefaultValues(processor);
+
+            auto values = defaults;
+            values[Parameters::indexFeedback] = 0.75f;
+            values[Parameters::indexDryWet] = 0.3f;
+            values[Parameters::indexFilterCutoff] = 2500.0f;
+            values[Parameters::indexVoices] = 2.0f;
+
+            Presets::PresetBank bank;
+            bank.addPreset("Slow", values);
+            bank.addPreset(juce::String::fromUTF8("Più lento"), defaults);
+
+            juce::MemoryBlock state;
+            {
+                juce::MemoryOutputStream out(state, false);
+                Presets::writeState(out, values, bank);
+            }
+
+            beginTest("Write/read round trip");
+            {
+                auto readValues = defaults;
+                Presets::PresetBank readBank;
+
+                expect(Presets::readState(state.getData(), static_cast<int>(state.getSize()), readValues, readBank));
+                expect(readValues == values);
+                expectEquals(readBank.getNumPresets(), 2);
+
+                for (int n = 0; n < bank.getNumPresets(); ++n)
+                    if (auto* preset = readBank.getPreset(n))
+                    {
+                        expectEquals(preset->name, bank.getPreset(n)->name);
+                        expect(preset->values == bank.getPreset(n)->values);
+                    }
+            }
+
+            beginTest("Processor state round trip");
+            {
+                for (int i = 0; i < Parameters::numParameters; ++i)
+                    ToolHelpers::setParameter(processor, Parameters::allIDs[i], values[(size_t)i]);
+
+                juce::MemoryBlock processorState;
+                processor.getStateInformation(processorState);
+
+                FlangerAudioProcessor restored;
+                restored.setStateInformation(processorState.getData(), static_cast<int>(processorState.getSize()));
+
+                expect(getCurrentValues(restored) == getCurrentValues(processor));
+            }
+
+            beginTest("Old APVTS XML blob");
+            {
+                juce::XmlElement xml("FLG");
+                auto addParam = [&xml](const juce::String& id, double value)
+                    {
+                        auto* param = xml.createNewChildElement("PARAM");
+                        param->setAttribute("id", id);
+                        param->setAttribute("value", value);
+                    };
+
+                addParam(Parameters::nameFeedback, 0.42);
+                addParam(Parameters::nameModFrequency, 3.0);
+                addParam("removedParameter", 1.0);
+
+                auto readValues = defaults;
+                Presets::readXmlValues(xml, readValues);
+
+                auto expected = defaults;
+                expected[Parameters::indexFeedback] = 0.42f;
+                expected[Parameters::indexModFrequency] = 3.0f;
+                expect(readValues == expected);
+
+                // Dal blob dell'host: readState lo rifiuta e si passa all'XML
+                juce::MemoryBlock blob;
+                juce::AudioProcessor::copyXmlToBinary(xml, blob);
+
+                Presets::PresetBank readBank;
+                auto binaryValues = defaults;
+                expect(!Presets::readState(blob.getData(), static_cast<int>(blob.getSize()), binaryValues, readBank));
+
+                FlangerAudioProcessor restored;
+                restored.setStateInformation(blob.getData(), static_cast<int>(blob.getSize()));
+
+                const auto restoredValues = getCurrentValues(restored);
+                expectWithinAbsoluteError(restoredValues[Parameters::indexFeedback], 0.42f, 1.0e-6f);
+                expectWithinAbsoluteError(restoredValues[Parameters::indexModFrequency], 3.0f, 1.0e-6f);
+                expectEquals(restoredValues[Parameters::indexDryWet], defaults[Parameters::indexDryWet]);
+            }
+
+            beginTest("Unknown hashes are ignored");
+            {
+                juce::MemoryBlock data;
+                {
+                    juce::MemoryOutputStream out(data, false);
+                    out.writeInt(static_cast<int>(Presets::stateMagic));
+                    out.writeShort(static_cast<short>(Presets::stateVersion));
+                    out.writeShort(3);
+                    out.writeInt(static_cast<int>(Presets::hashID("parameterFromTheFuture")));
+                    out.writeFloat(123.0f);
+                    out.writeInt(static_cast<int>(Presets::hashID(Parameters::nameFeedback)));
+                    out.writeFloat(0.5f);
+                    out.writeInt(static_cast<int>(Presets::hashID("anotherOne")));
+                    out.writeFloat(-1.0f);
+                    out.writeShort(0);
+                }
+
+                auto readValues = defaults;
+                Presets::PresetBank readBank;
+                expect(Presets::readState(data.getData(), static_cast<int>(data.getSize()), readValues, readBank));
+
+                auto expected = defaults;
+                expected[Parameters::indexFeedback] = 0.5f;
+                expect(readValues == expected);
+                expectEquals(readBank.getNumPresets(), 0);
+            }
+
+            beginTest("Truncated data");
+            {
+                // Intestazione (magic, versione), poi numero di valori e coppie hash/valore
+                const int valuesEnd = 6 + 2 + Parameters::numParameters * 8;
+                const int size = static_cast<int>(state.getSize());
+
+                for (int length = 0; length < size; ++length)
+                {
+                    // Un byte dopo i valori: il numero di preset è incompleto, il banco resta vuoto
+                    if (length == valuesEnd || length == valuesEnd + 1)
+                        continue;
+
+                    auto readValues = defaults;
+                    Presets::PresetBank readBank;
+                    expect(!Presets::readState(state.getData(), length, readValues, readBank), "length " + juce::String(length));
+                }
+
+                // Il processore ignora lo stato troncato
+                FlangerAudioProcessor restored;
+                restored.setStateInformation(state.getData(), valuesEnd - 4);
+                expect(getCurrentValues(restored) == defaults);
+            }
+
+            beginTest("Newer state version is rejected");
+            {
+                juce::MemoryBlock newer(state);
+                const auto version = static_cast<juce::uint16>(Presets::stateVersion + 1);
+                newer[4] = static_cast<char>(version & 0xff);
+                newer[5] = static_cast<char>(version >> 8);
+
+                auto readValues = defaults;
+                Presets::PresetBank readBank;
+                expect(!Presets::readState(newer.getData(), static_cast<int>(newer.getSize()), readValues, readBank));
+                expect(readValues == defaults);
+
+                FlangerAudioProcessor restored;
+                restored.setStateInformation(newer.getData(), static_cast<int>(newer.getSize()));
+                expect(getCurrentValues(restored) == defaults);
+            }
+        }
+    };
+
+    static StateFormatTests stateFormatTests;
+
+    //==============================================================================
+    // Il motore fuso deve restare intercambiabile con quello a stadi: stesso ingresso, stessa uscita
+    class ProcessingModeTests : public juce::UnitTest
+    {
+    public:
+        ProcessingModeTests() : juce::UnitTest("Fused vs staged", "FlangeFlicker") {}
+
+        void runTest() override
+        {
+            static constexpr const char* interpolationNames[] = { "linear", "cubic", "lagrange", "thiran", "sinc" };
+
+            for (int interpolation = 0; interpolation < 5; ++interpolation)
+                for (const int interval : { 1, 16 })
+                    for (const int engine : { 0, 1 })
+                    {
+                        beginTest(juce::String(interpolationNames[interpolation]) + ", control interval " + juce::String(interval)
+                            + (engine == 0 ? ", biquad" : ", state variable"));
+
+                        const float error = compareModes([=](FlangerAudioProcessor& processor)
+                            {
+                                ToolHelpers::setParameter(processor, Parameters::nameInterpolation, static_cast<float>(interpolation));
+                                ToolHelpers::setParameter(processor, Parameters::nameDryWet, 0.5f);
+                                ToolHelpers::setParameter(processor, Parameters::nameFeedback, 0.9f);
+                                ToolHelpers::setParameter(processor, Parameters::nameModFrequency, 2.0f);
+                                ToolHelpers::setParameter(processor, Parameters::namePhaseDelta, 0.25f);
+                                ToolHelpers::setParameter(processor, Parameters::nameFilterActive, 1.0f);
+                                ToolHelpers::setParameter(processor, Parameters::nameFilterEngine, static_cast<float>(engine));
+                                ToolHelpers::setParameter(processor, Parameters::nameFilterModDepth, engine == 1 ? 1.0f : 0.0f);
+                                processor.setControlInterval(interval);
+                            });
+
+                        expectLessOrEqual(error, maxModeError, "max abs error " + juce::String(error));
+                    }
+        }
+
+    private:
+        static constexpr float maxModeError = 1.0e-5f;
+
+        // Massimo errore assoluto tra i due motori, stereo, con un cambio di parametri a metà
+        template <typename Setup>
+        static float compareModes(Setup&& setup)
+        {
+            constexpr double sampleRate = 48000.0;
+            constexpr int blockSize = 256;
+            constexpr int numBlocks = 200;
+
+            FlangerAudioProcessor staged, fused;
+            fused.setProcessingMode(FlangerAudioProcessor::ProcessingMode::fused);
+
+            for (auto* processor : { &staged, &fused })
+            {
+                setup(*processor);
+                processor->setRateAndBufferSizeDetails(sampleRate, blockSize);
+                processor->prepareToPlay(sampleRate, blockSize);
+            }
+
+            juce::AudioBuffer<float> stagedBlock(2, blockSize), fusedBlock(2, blockSize);
+            juce::MidiBuffer midi;
+            juce::Random random(42);
+            float maxError = 0.0f;
+
+            for (int b = 0; b < numBlocks; ++b)
+            {
+                if (b == numBlocks / 2)
+                    for (auto* processor : { &staged, &fused })
+                    {
+                        ToolHelpers::setParameter(*processor, Parameters::nameDelayTime, 4.0f);
+                        ToolHelpers::setParameter(*processor, Parameters::nameFilterCutoff, 1500.0f);
+                    }
+
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int s = 0; s < blockSize; ++s)
+                        stagedBlock.setSample(ch, s, random.nextFloat() - 0.5f);
+
+                fusedBlock.makeCopyOf(stagedBlock);
+
+                staged.processBlock(stagedBlock, midi);
+                fused.processBlock(fusedBlock, midi);
+
+                for (int ch = 0; ch < 2; ++ch)
+                    for (int s = 0; s < blockSize; ++s)
+                        maxError = juce::jmax(maxError, std::abs(stagedBlock.getSample(ch, s) - fusedBlock.getSample(ch, s)));
+            }
+
+            return maxError;
+        }
+    };
+
+    static ProcessingModeTests processingModeTests;
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const juce::ArgumentList args(argc, argv);
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+
+    if (args.containsOption("--category"))
+        runner.runTestsInCategory(args.getValueForOption("--category"));
+    else
+        runner.runAllTests();
+
+    int failures = 0;
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult(i)->failures;
+
+    std::cerr << failures << " failure(s)" << std::endl;
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <JuceHeader.h>
+#include <iostream>
+
+// Utility condivise dai target da console (render offline, benchmark)
+namespace ToolHelpers
+{
+    inline juce::RangedAudioParameter* findParameter(juce::AudioProcessor& processor, const juce::String& paramID)
+    {
+        for (auto* param : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+                if (ranged->paramID == paramID)
+                    return ranged;
+
+        return nullptr;
+    }
+
+    // Imposta un parametro nelle sue unità reali (ms, Hz, dB, indice per le scelte)
+    inline bool setParameter(juce::AudioProcessor& processor, const juce::String& paramID, float value)
+    {
+        if (auto* param = findParameter(processor, paramID))
+        {
+            param->setValueNotifyingHost(param->convertTo0to1(value));
+            return true;
+        }
+
+        return false;
+    }
+
+    // "id=valore" -> setParameter
+    inline bool setParameterFromString(juce::AudioProcessor& processor, const juce::String& assignment)
+    {
+        const auto paramID = assignment.upToFirstOccurrenceOf("=", false, false).trim();
+        const auto valueText = assignment.fromFirstOccurrenceOf("=", false, false).trim();
+
+        if (paramID.isEmpty() || valueText.isEmpty())
+            return false;
+
+        return setParameter(processor, paramID, valueText.getFloatValue());
+    }
+
+    // Accetta sia lo stato binario di getStateInformation sia un file XML in chiaro
+    inline bool loadStateFile(juce::AudioProcessor& processor, const juce::File& file)
+    {
+        juce::MemoryBlock data;
+        if (!file.loadFileAsData(data) || data.isEmpty())
+            return false;
+
+        if (auto xml = juce::parseXML(file))
+        {
+            juce::MemoryBlock binary;
+            juce::AudioProcessor::copyXmlToBinary(*xml, binary);
+            processor.setStateInformation(binary.getData(), static_cast<int>(binary.getSize()));
+        }
+        else
+        {
+            processor.setStateInformation(data.getData(), static_cast<int>(data.getSize()));
+        }
+
+        return true;
+    }
+
+    // Layout canonici (mono, stereo, 5.1...) sul bus di ingresso e di uscita, da chiamare
+    // prima di prepareToPlay. false se il processore non lo supporta
+    inline bool setChannelCount(juce::AudioProcessor& processor, int numInputChannels, int numOutputChannels)
+    {
+        auto layout = processor.getBusesLayout();
+        if (layout.inputBuses.isEmpty() || layout.outputBuses.isEmpty())
+            return false;
+
+        layout.inputBuses.getReference(0) = juce::AudioChannelSet::canonicalChannelSet(numInputChannels);
+        layout.outputBuses.getReference(0) = juce::AudioChannelSet::canonicalChannelSet(numOutputChannels);
+
+        return processor.setBusesLayout(layout);
+    }
+
+    inline bool setChannelCount(juce::AudioProcessor& processor, int numChannels)
+    {
+        return setChannelCount(processor, numChannels, numChannels);
+    }
+
+    inline void printParameters(juce::AudioProcessor& processor)
+    {
+        for (auto* param : processor.getParameters())
+            if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(param))
+            {
+                const auto& range = ranged->getNormalisableRange();
+                std::cout << ranged->paramID << "  [" << range.start << " .. " << range.end << "]  "
+                          << ranged->getName(64) << "\n";
+            }
+    }
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <JuceHeader.h>
+
+//==============================================================
+//                       TripleBuffer
+//==============================================================
+// Un thread scrive valori completi, un altro prende sempre l'ultima versione pubblicata:
+// nessun lock, nessuno dei due aspetta l'altro. Con più scrittori li serializza il chiamante
+template <typename Values>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    explicit TripleBuffer(const Values& initialValues) { buffers.fill(initialValues); }
+
+    // Scrittore
+    Values& getWriteBuffer() noexcept { return buffers[(size_t)writeIndex]; }
+    void publish() noexcept { writeIndex = middle.exchange(writeIndex | newDataFlag) & indexMask; }
+
+    // Lettore: true se c'è una versione nuova, che diventa getReadBuffer()
+    bool acquire() noexcept
+    {
+        if ((middle.load() & newDataFlag) == 0)
+            return false;
+
+        readIndex = middle.exchange(readIndex) & indexMask;
+        return true;
+    }
+
+    const Values& getReadBuffer() const noexcept { return buffers[(size_t)readIndex]; }
+
+private:
+    static constexpr int indexMask = 3, newDataFlag = 4;
+
+    std::array<Values, 3> buffers{};
+    int writeIndex = 0, readIndex = 1;
+    std::atomic<int> middle{ 2 };
+};